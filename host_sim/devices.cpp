@@ -0,0 +1,419 @@
+/*
+ * Copyright (C) 2026 by Stefan Rothe
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "devices.h"
+#include "sim.h"
+
+/******************************************************************************
+ * class SimBNO055
+ *****************************************************************************/
+
+#define BNO055_EULER 0x1A
+#define BNO055_LINEAR_ACCEL 0x28
+
+SimBNO055::SimBNO055() :
+    _pointer(0) {
+    memset(_registers, 0, sizeof(_registers));
+    _registers[0x00] = 0xA0; // chip id
+}
+
+bool SimBNO055::receive(const uint8_t* data, size_t length) {
+    if (length == 0) {
+        return true;
+    }
+
+    _pointer = data[0] & 0x7F;
+    for (size_t i = 1; i < length; ++i) {
+        _registers[_pointer] = data[i];
+        _pointer = (_pointer + 1) & 0x7F;
+    }
+
+    return true;
+}
+
+size_t SimBNO055::request(uint8_t* data, size_t length) {
+    for (size_t i = 0; i < length; ++i) {
+        data[i] = _registers[_pointer];
+        _pointer = (_pointer + 1) & 0x7F;
+    }
+
+    return length;
+}
+
+void SimBNO055::setEuler(double heading, double roll, double pitch) {
+    if (heading < 0) {
+        heading += 360;
+    }
+
+    setVector(BNO055_EULER, lround(heading * 16), lround(roll * 16), lround(pitch * 16));
+}
+
+void SimBNO055::setLinearAcceleration(double x, double y, double z) {
+    setVector(BNO055_LINEAR_ACCEL, lround(x * 100), lround(y * 100), lround(z * 100));
+}
+
+void SimBNO055::setVector(uint8_t reg, int16_t x, int16_t y, int16_t z) {
+    int16_t values[3] = { x, y, z };
+    for (uint8_t i = 0; i < 3; ++i) {
+        _registers[reg + 2 * i] = static_cast<uint16_t>(values[i]) & 0xFF;
+        _registers[reg + 2 * i + 1] = static_cast<uint16_t>(values[i]) >> 8;
+    }
+}
+
+/******************************************************************************
+ * class SimEEPROM
+ *****************************************************************************/
+
+SimEEPROM::SimEEPROM() :
+    _busyUntilNs(0),
+    _pageWrites(0),
+    _pointer(0) {
+    memset(_memory, 0xFF, sizeof(_memory));
+}
+
+bool SimEEPROM::busy() const {
+    return sim::nowNs() < _busyUntilNs;
+}
+
+bool SimEEPROM::receive(const uint8_t* data, size_t length) {
+    if (busy()) {
+        // no acknowledge during the internal write cycle
+        return false;
+    }
+
+    if (length < 2) {
+        return true;
+    }
+
+    _pointer = ((data[0] << 8) | data[1]) % SIZE;
+    if (length == 2) {
+        return true;
+    }
+
+    // page write: the address wraps around within the page
+    uint16_t page = _pointer - _pointer % PAGE_SIZE;
+    for (size_t i = 2; i < length; ++i) {
+        _memory[_pointer] = data[i];
+        _pointer = page + (_pointer + 1) % PAGE_SIZE;
+    }
+
+    ++_pageWrites;
+    _busyUntilNs = sim::nowNs() + WRITE_CYCLE_US * 1000;
+    return true;
+}
+
+size_t SimEEPROM::request(uint8_t* data, size_t length) {
+    if (busy()) {
+        return 0;
+    }
+
+    for (size_t i = 0; i < length; ++i) {
+        data[i] = _memory[_pointer];
+        _pointer = (_pointer + 1) % SIZE;
+    }
+
+    return length;
+}
+
+/******************************************************************************
+ * class SimPCA9557
+ *****************************************************************************/
+
+SimPCA9557::SimPCA9557() :
+    _pointer(0) {
+    _registers[0] = 0x00;
+    _registers[1] = 0xFF;
+    _registers[2] = 0xF0;
+    _registers[3] = 0xFF;
+}
+
+bool SimPCA9557::receive(const uint8_t* data, size_t length) {
+    if (length == 0) {
+        return true;
+    }
+
+    _pointer = data[0] & 0x03;
+    for (size_t i = 1; i < length; ++i) {
+        if (_pointer != 0) {
+            _registers[_pointer] = data[i];
+        }
+    }
+
+    return true;
+}
+
+size_t SimPCA9557::request(uint8_t* data, size_t length) {
+    for (size_t i = 0; i < length; ++i) {
+        data[i] = _registers[_pointer];
+    }
+
+    return length;
+}
+
+/******************************************************************************
+ * class SimSSD1306
+ *****************************************************************************/
+
+#define SSD1306_COLUMN_ADDRESS 0x21
+#define SSD1306_PAGE_ADDRESS 0x22
+
+static uint8_t ssd1306ParamCount(uint8_t command) {
+    switch (command) {
+    case SSD1306_COLUMN_ADDRESS:
+    case SSD1306_PAGE_ADDRESS:
+        return 2;
+    case 0x20: case 0x81: case 0x8D: case 0xA8: case 0xD3:
+    case 0xD5: case 0xD9: case 0xDA: case 0xDB:
+        return 1;
+    default:
+        return 0;
+    }
+}
+
+SimSSD1306::SimSSD1306() :
+    _column(0),
+    _columnEnd(WIDTH - 1),
+    _columnStart(0),
+    _command(0),
+    _dataBytes(0),
+    _page(0),
+    _pageEnd(PAGES - 1),
+    _pageStart(0),
+    _paramCount(0),
+    _transfers(0) {
+    memset(_ram, 0, sizeof(_ram));
+}
+
+bool SimSSD1306::receive(const uint8_t* data, size_t length) {
+    if (length == 0) {
+        return true;
+    }
+
+    // control byte: D/C bit selects data or command stream
+    bool isData = data[0] & 0x40;
+    if (isData) {
+        ++_transfers;
+    }
+
+    for (size_t i = 1; i < length; ++i) {
+        if (isData) {
+            this->data(data[i]);
+        }
+        else {
+            command(data[i]);
+        }
+    }
+
+    return true;
+}
+
+void SimSSD1306::command(uint8_t data) {
+    if (_paramCount == 0) {
+        _command = data;
+        _paramCount = ssd1306ParamCount(data);
+        return;
+    }
+
+    --_paramCount;
+    _params[ssd1306ParamCount(_command) - 1 - _paramCount] = data;
+    if (_paramCount > 0) {
+        return;
+    }
+
+    if (_command == SSD1306_COLUMN_ADDRESS) {
+        _columnStart = _params[0] % WIDTH;
+        _columnEnd = _params[1] % WIDTH;
+        _column = _columnStart;
+    }
+    else if (_command == SSD1306_PAGE_ADDRESS) {
+        _pageStart = _params[0] % PAGES;
+        _pageEnd = _params[1] % PAGES;
+        _page = _pageStart;
+    }
+}
+
+void SimSSD1306::data(uint8_t data) {
+    // horizontal addressing mode
+    ++_dataBytes;
+    _ram[_page * WIDTH + _column] = data;
+    if (_column < _columnEnd) {
+        ++_column;
+        return;
+    }
+
+    _column = _columnStart;
+    _page = _page < _pageEnd ? _page + 1 : _pageStart;
+}
+
+/******************************************************************************
+ * class SimVL53L1X
+ *****************************************************************************/
+
+#define VL53L1X_REGISTER_COUNT 0x10000
+#define VL53L1X_SOFT_RESET 0x0000
+#define VL53L1X_VHV_CONFIG__TIMEOUT_MACROP_LOOP_BOUND 0x0008
+#define VL53L1X_VHV_CONFIG__INIT 0x000B
+#define VL53L1X_OSC_MEASURED__FAST_OSC__FREQUENCY 0x0006
+#define VL53L1X_GPIO__TIO_HV_STATUS 0x0031
+#define VL53L1X_SYSTEM__INTERMEASUREMENT_PERIOD 0x006C
+#define VL53L1X_SYSTEM__INTERRUPT_CLEAR 0x0086
+#define VL53L1X_SYSTEM__MODE_START 0x0087
+#define VL53L1X_RESULT__RANGE_STATUS 0x0089
+#define VL53L1X_RESULT__STREAM_COUNT 0x008B
+#define VL53L1X_RESULT__DSS_ACTUAL_EFFECTIVE_SPADS_SD0 0x008C
+#define VL53L1X_RESULT__AMBIENT_COUNT_RATE_MCPS_SD0 0x0090
+#define VL53L1X_RESULT__FINAL_CROSSTALK_CORRECTED_RANGE_MM_SD0 0x0096
+#define VL53L1X_RESULT__PEAK_SIGNAL_COUNT_RATE_CROSSTALK_CORRECTED_MCPS_SD0 0x0098
+#define VL53L1X_PHASECAL_RESULT__VCSEL_START 0x00D8
+#define VL53L1X_RESULT__OSC_CALIBRATE_VAL 0x00DE
+#define VL53L1X_IDENTIFICATION__MODEL_ID 0x010F
+
+#define RANGE_STATUS_VALID 9
+#define RANGE_STATUS_SIGNAL_FAIL 6
+// gph_id bit of the result, set on every other measurement
+#define RANGE_STATUS_GPH_ID 0x80
+#define NO_PIN 0xFF
+
+SimVL53L1X::SimVL53L1X() :
+    _distance(500),
+    _interruptPin(NO_PIN),
+    _measurements(0),
+    _nextMeasurementNs(0),
+    _pointer(0),
+    _registers(new uint8_t[VL53L1X_REGISTER_COUNT]),
+    _resultReads(0),
+    _running(false) {
+    reset();
+}
+
+bool SimVL53L1X::receive(const uint8_t* data, size_t length) {
+    update();
+    if (length < 2) {
+        return true;
+    }
+
+    _pointer = (data[0] << 8) | data[1];
+    for (size_t i = 2; i < length; ++i) {
+        uint16_t reg = _pointer;
+        _registers[reg] = data[i];
+        _pointer = _pointer + 1;
+        if (reg == VL53L1X_SYSTEM__INTERRUPT_CLEAR && (data[i] & 0x01)) {
+            _registers[VL53L1X_GPIO__TIO_HV_STATUS] |= 0x01;
+            updateInterruptPin();
+        }
+
+        if (reg == VL53L1X_SOFT_RESET && data[i] == 0x00) {
+            reset();
+            updateInterruptPin();
+        }
+
+        if (reg == VL53L1X_SYSTEM__MODE_START) {
+            if (data[i] & 0x40) {
+                _running = true;
+                _nextMeasurementNs = sim::nowNs();
+            }
+
+            if (data[i] & 0x80) {
+                _running = false;
+            }
+        }
+    }
+
+    return true;
+}
+
+void SimVL53L1X::setInterruptPin(uint8_t pin) {
+    _interruptPin = pin;
+    updateInterruptPin();
+}
+
+size_t SimVL53L1X::request(uint8_t* data, size_t length) {
+    update();
+    if (_pointer == VL53L1X_RESULT__RANGE_STATUS) {
+        ++_resultReads;
+    }
+
+    for (size_t i = 0; i < length; ++i) {
+        data[i] = _registers[_pointer];
+        _pointer = _pointer + 1;
+    }
+
+    return length;
+}
+
+void SimVL53L1X::reset() {
+    memset(_registers, 0, VL53L1X_REGISTER_COUNT);
+    write16(VL53L1X_IDENTIFICATION__MODEL_ID, 0xEACC);
+    write16(VL53L1X_OSC_MEASURED__FAST_OSC__FREQUENCY, 0xBCCC);
+    write16(VL53L1X_RESULT__OSC_CALIBRATE_VAL, 0x0200);
+    _registers[VL53L1X_VHV_CONFIG__TIMEOUT_MACROP_LOOP_BOUND] = 0x05;
+    _registers[VL53L1X_VHV_CONFIG__INIT] = 0xA0;
+    _registers[VL53L1X_GPIO__TIO_HV_STATUS] = 0x03;
+    _registers[VL53L1X_PHASECAL_RESULT__VCSEL_START] = 0x0B;
+    _running = false;
+}
+
+void SimVL53L1X::update() {
+    if (!_running || sim::nowNs() < _nextMeasurementNs) {
+        return;
+    }
+
+    uint32_t periodMs = 50;
+    uint16_t osc = read16(VL53L1X_RESULT__OSC_CALIBRATE_VAL);
+    if (osc > 0 && read32(VL53L1X_SYSTEM__INTERMEASUREMENT_PERIOD) > 0) {
+        periodMs = read32(VL53L1X_SYSTEM__INTERMEASUREMENT_PERIOD) / osc;
+    }
+
+    bool valid = _distance >= 0;
+    // the driver applies a correction gain of 2011/2048
+    uint32_t raw = valid ? (static_cast<uint32_t>(_distance) * 2048 + 1005) / 2011 : 0;
+    ++_registers[VL53L1X_RESULT__STREAM_COUNT];
+    _registers[VL53L1X_RESULT__RANGE_STATUS] = valid ? RANGE_STATUS_VALID : RANGE_STATUS_SIGNAL_FAIL;
+    if (_registers[VL53L1X_RESULT__STREAM_COUNT] & 1) {
+        _registers[VL53L1X_RESULT__RANGE_STATUS] |= RANGE_STATUS_GPH_ID;
+    }
+    write16(VL53L1X_RESULT__DSS_ACTUAL_EFFECTIVE_SPADS_SD0, 0x2000);
+    write16(VL53L1X_RESULT__AMBIENT_COUNT_RATE_MCPS_SD0, 0x0040);
+    write16(VL53L1X_RESULT__FINAL_CROSSTALK_CORRECTED_RANGE_MM_SD0, raw);
+    write16(VL53L1X_RESULT__PEAK_SIGNAL_COUNT_RATE_CROSSTALK_CORRECTED_MCPS_SD0, valid ? 0x0400 : 0x0004);
+    _registers[VL53L1X_GPIO__TIO_HV_STATUS] &= ~0x01;
+    ++_measurements;
+    while (_nextMeasurementNs <= sim::nowNs()) {
+        _nextMeasurementNs += static_cast<uint64_t>(periodMs) * 1000000;
+    }
+
+    updateInterruptPin();
+}
+
+void SimVL53L1X::updateInterruptPin() {
+    if (_interruptPin != NO_PIN) {
+        sim::setDigitalInput(_interruptPin, _registers[VL53L1X_GPIO__TIO_HV_STATUS] & 0x01 ? HIGH : LOW);
+    }
+}
+
+uint16_t SimVL53L1X::read16(uint16_t reg) const {
+    return (_registers[reg] << 8) | _registers[static_cast<uint16_t>(reg + 1)];
+}
+
+uint32_t SimVL53L1X::read32(uint16_t reg) const {
+    return (static_cast<uint32_t>(read16(reg)) << 16) | read16(reg + 2);
+}
+
+void SimVL53L1X::write16(uint16_t reg, uint16_t value) {
+    _registers[reg] = value >> 8;
+    _registers[static_cast<uint16_t>(reg + 1)] = value & 0xFF;
+}
@@ -0,0 +1,157 @@
+/*
+ * Copyright (C) 2026 by Stefan Rothe
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef DEVICES_H
+#define DEVICES_H
+
+#include <Wire.h>
+
+/******************************************************************************
+ * class SimBNO055
+ *****************************************************************************/
+
+class SimBNO055 : public I2CSlave {
+public:
+    SimBNO055();
+    virtual bool receive(const uint8_t* data, size_t length);
+    virtual size_t request(uint8_t* data, size_t length);
+    void setEuler(double heading, double roll, double pitch);
+    void setLinearAcceleration(double x, double y, double z);
+private:
+    void setVector(uint8_t reg, int16_t x, int16_t y, int16_t z);
+    uint8_t _pointer;
+    uint8_t _registers[0x80];
+};
+
+/******************************************************************************
+ * class SimEEPROM (24AA64)
+ *****************************************************************************/
+
+class SimEEPROM : public I2CSlave {
+public:
+    static const uint16_t SIZE = 8192;
+    static const uint8_t PAGE_SIZE = 32;
+    static const uint32_t WRITE_CYCLE_US = 5000;
+
+    SimEEPROM();
+    virtual bool receive(const uint8_t* data, size_t length);
+    virtual size_t request(uint8_t* data, size_t length);
+    bool busy() const;
+    uint8_t* memory() { return _memory; }
+    uint32_t pageWrites() const { return _pageWrites; }
+private:
+    uint64_t _busyUntilNs;
+    uint8_t _memory[SIZE];
+    uint32_t _pageWrites;
+    uint16_t _pointer;
+};
+
+/******************************************************************************
+ * class SimPCA9557
+ *****************************************************************************/
+
+class SimPCA9557 : public I2CSlave {
+public:
+    SimPCA9557();
+    virtual bool receive(const uint8_t* data, size_t length);
+    virtual size_t request(uint8_t* data, size_t length);
+    void setInput(uint8_t value) { _registers[0] = value; }
+private:
+    uint8_t _pointer;
+    uint8_t _registers[4];
+};
+
+/******************************************************************************
+ * class SimSSD1306
+ *****************************************************************************/
+
+class SimSSD1306 : public I2CSlave {
+public:
+    static const uint8_t WIDTH = 128;
+    static const uint8_t PAGES = 4;
+
+    SimSSD1306();
+    virtual bool receive(const uint8_t* data, size_t length);
+    virtual size_t request(uint8_t* data, size_t length) { return 0; }
+    uint32_t dataBytes() const { return _dataBytes; }
+    const uint8_t* ram() const { return _ram; }
+    uint32_t transfers() const { return _transfers; }
+private:
+    void command(uint8_t data);
+    void data(uint8_t data);
+    uint8_t _column;
+    uint8_t _columnEnd;
+    uint8_t _columnStart;
+    uint8_t _command;
+    uint32_t _dataBytes;
+    uint8_t _page;
+    uint8_t _pageEnd;
+    uint8_t _pageStart;
+    uint8_t _params[2];
+    uint8_t _paramCount;
+    uint8_t _ram[WIDTH * PAGES];
+    uint32_t _transfers;
+};
+
+/******************************************************************************
+ * class SimVL53L1X
+ *****************************************************************************/
+
+class SimVL53L1X : public I2CSlave {
+public:
+    SimVL53L1X();
+    virtual bool receive(const uint8_t* data, size_t length);
+    virtual size_t request(uint8_t* data, size_t length);
+
+    /**
+     * Sets the distance the sensor will see. A negative distance simulates
+     * a failed measurement (no target).
+     */
+    void setDistance(int32_t mm) { _distance = mm; }
+
+    /**
+     * Connects GPIO1 to a digital input of the firmware. It is low while a
+     * measurement is ready.
+     */
+    void setInterruptPin(uint8_t pin);
+
+    /**
+     * Takes the measurements that are due. Without tick(), measurements are
+     * only taken when the sensor is accessed, which is enough for polling.
+     */
+    void tick() { update(); }
+    uint32_t measurements() const { return _measurements; }
+    uint32_t resultReads() const { return _resultReads; }
+private:
+    // state after power-up or a soft reset
+    void reset();
+    void update();
+    void updateInterruptPin();
+    uint16_t read16(uint16_t reg) const;
+    uint32_t read32(uint16_t reg) const;
+    void write16(uint16_t reg, uint16_t value);
+    int32_t _distance;
+    uint8_t _interruptPin;
+    uint32_t _measurements;
+    uint64_t _nextMeasurementNs;
+    uint16_t _pointer;
+    uint8_t* _registers;
+    uint32_t _resultReads;
+    bool _running;
+};
+
+#endif
@@ -0,0 +1,301 @@
+/*
+ * Copyright (C) 2026 by Stefan Rothe
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Checks the I2C transaction queue of the firmware against recording I2C
+ * slaves:
+ * - transactions are executed highest priority first, in order of
+ *   submission within a priority
+ * - transactions queued by a callback take part in the same loop()
+ * - loop() leaves lower priorities and transactions beyond the time budget
+ *   queued for the next call
+ * - register addresses, data and the success flag reach the right places
+ * - a full queue rejects transactions and counts them
+ * - transfers run in the background, callbacks are called by the next
+ *   loop() or poll() after the transfer
+ * - the display sends the whole frame again after a chunk has not been
+ *   acknowledged
+ * - blocking register reads fail if the device returns less data
+ *
+ * usage: i2c_queue_check
+ */
+
+#include <string>
+#include <Wire.h>
+#include "devices.h"
+#include "sim.h"
+#include "../smartglove_neo/i2c_queue.cpp"
+#include "../smartglove_neo/i2cdevice.cpp"
+#include "../smartglove_neo/display.cpp"
+
+/******************************************************************************
+ * class RecordingSlave
+ *****************************************************************************/
+
+class RecordingSlave : public I2CSlave {
+public:
+    RecordingSlave(char name, std::string& transfers) :
+        _transfers(transfers),
+        _name(name) {
+    }
+
+    virtual bool receive(const uint8_t* data, size_t length) {
+        char text[8];
+        _transfers += _name;
+        for (size_t i = 0; i < length; ++i) {
+            snprintf(text, sizeof(text), ":%02x", data[i]);
+            _transfers += text;
+        }
+
+        _transfers += ' ';
+        return true;
+    }
+
+    virtual size_t request(uint8_t* data, size_t length) {
+        for (size_t i = 0; i < length; ++i) {
+            data[i] = 0xA0 + i;
+        }
+
+        _transfers += _name;
+        _transfers += "? ";
+        return length;
+    }
+private:
+    std::string& _transfers;
+    char _name;
+};
+
+/******************************************************************************
+ * class FailingPanel
+ *****************************************************************************/
+
+class FailingPanel : public SimSSD1306 {
+public:
+    FailingPanel() :
+        _failIn(0) {
+    }
+
+    /**
+     * Does not acknowledge the transfer after the next count transfers.
+     */
+    void failAfter(uint8_t count) { _failIn = count + 1; }
+
+    virtual bool receive(const uint8_t* data, size_t length) {
+        if (_failIn > 0) {
+            --_failIn;
+            if (_failIn == 0) {
+                return false;
+            }
+        }
+
+        return SimSSD1306::receive(data, length);
+    }
+private:
+    uint8_t _failIn;
+};
+
+/******************************************************************************
+ * class ShortSlave
+ *****************************************************************************/
+
+class ShortSlave : public I2CSlave {
+public:
+    virtual bool receive(const uint8_t* data, size_t length) { return true; }
+
+    virtual size_t request(uint8_t* data, size_t length) {
+        // one byte less than requested
+        memset(data, 0, length);
+        return length > 0 ? length - 1 : 0;
+    }
+};
+
+/******************************************************************************
+ * class RegisterReader
+ *****************************************************************************/
+
+class RegisterReader : public I2CDevice {
+public:
+    RegisterReader(uint8_t address) :
+        I2CDevice(address) {
+    }
+
+    using I2CDevice::readRegisters16;
+};
+
+/******************************************************************************
+ * checks
+ *****************************************************************************/
+
+static std::string transfers;
+static bool ok = true;
+static uint8_t buffer[4];
+static uint8_t results = 0;
+static uint8_t successes = 0;
+
+static void expect(const char* name, bool condition) {
+    printf("%-40s %s\n", name, condition ? "ok" : "FAILED");
+    ok = ok && condition;
+}
+
+static I2CTransaction transaction(uint8_t address, uint16_t reg, uint8_t priority) {
+    I2CTransaction result;
+    result.address = address;
+    result.callback = NULL;
+    result.context = NULL;
+    result.data = buffer;
+    result.length = 1;
+    result.priority = priority;
+    result.read = false;
+    result.reg = reg;
+    result.regSize = 1;
+    return result;
+}
+
+static void countResult(void* context, bool success) {
+    ++results;
+    if (success) {
+        ++successes;
+    }
+}
+
+static void queueFollowUp(void* context, bool success) {
+    I2CQueue.submit(transaction(0x10, 0x05, I2C_PRIORITY_HIGH));
+}
+
+int main(int argc, char** argv) {
+    RecordingSlave a('a', transfers);
+    RecordingSlave b('b', transfers);
+    Wire.setClock(400000);
+    Wire.attach(0x10, &a);
+    Wire.attach(0x11, &b);
+    buffer[0] = 0x55;
+
+    transfers.clear();
+    I2CQueue.submit(transaction(0x10, 0x01, I2C_PRIORITY_MEDIUM));
+    I2CQueue.submit(transaction(0x11, 0x02, I2C_PRIORITY_HIGH));
+    I2CQueue.submit(transaction(0x10, 0x03, I2C_PRIORITY_MEDIUM));
+    I2CQueue.submit(transaction(0x11, 0x04, I2C_PRIORITY_HIGH));
+    I2CQueue.loop();
+    expect("priority order", transfers == "b:02:55 b:04:55 a:01:55 a:03:55 ");
+    expect("empty after loop", I2CQueue.empty());
+
+    transfers.clear();
+    I2CTransaction first = transaction(0x11, 0x02, I2C_PRIORITY_HIGH);
+    first.callback = queueFollowUp;
+    I2CQueue.submit(transaction(0x10, 0x01, I2C_PRIORITY_MEDIUM));
+    I2CQueue.submit(first);
+    I2CQueue.submit(transaction(0x11, 0x04, I2C_PRIORITY_HIGH));
+    I2CQueue.loop();
+    expect("callback queues follow-up", transfers == "b:02:55 b:04:55 a:05:55 a:01:55 ");
+
+    transfers.clear();
+    I2CTransaction read = transaction(0x10, 0x0102, I2C_PRIORITY_MEDIUM);
+    read.callback = countResult;
+    read.length = 3;
+    read.read = true;
+    read.regSize = 2;
+    I2CTransaction missing = transaction(0x12, 0x00, I2C_PRIORITY_MEDIUM);
+    missing.callback = countResult;
+    I2CQueue.submit(read);
+    I2CQueue.submit(missing);
+    I2CQueue.loop();
+    expect("16 bit register address", transfers == "a:01:02 a? ");
+    expect("read data", buffer[0] == 0xA0 && buffer[1] == 0xA1 && buffer[2] == 0xA2);
+    expect("success flags", results == 2 && successes == 1);
+
+    for (uint8_t i = 0; i <= I2C_QUEUE_CAPACITY; ++i) {
+        I2CQueue.submit(transaction(0x10, i, I2C_PRIORITY_MEDIUM));
+    }
+
+    expect("full queue rejects", I2CQueue.dropped() == 1);
+    I2CQueue.loop();
+
+    transfers.clear();
+    buffer[0] = 0x55;
+    I2CQueue.submit(transaction(0x10, 0x01, I2C_PRIORITY_LOW));
+    I2CQueue.submit(transaction(0x11, 0x02, I2C_PRIORITY_MEDIUM));
+    I2CQueue.submit(transaction(0x10, 0x03, I2C_PRIORITY_HIGH));
+    I2CQueue.loop(I2C_PRIORITY_MEDIUM);
+    expect("lower priorities stay queued", transfers == "a:03:55 b:02:55 " && !I2CQueue.empty());
+    I2CQueue.loop();
+    expect("and are executed later", transfers == "a:03:55 b:02:55 a:01:55 ");
+
+    transfers.clear();
+    for (uint8_t i = 0; i < 8; ++i) {
+        I2CQueue.submit(transaction(0x10, i, I2C_PRIORITY_LOW));
+    }
+
+    // one transaction takes about 100 us at 400 kHz
+    I2CQueue.loop(I2C_PRIORITY_LOW, 250);
+    expect("budget stops the loop", transfers == "a:00:55 a:01:55 a:02:55 ");
+    I2CQueue.submit(transaction(0x11, 0x08, I2C_PRIORITY_HIGH));
+    I2CQueue.loop();
+    expect("high priority overtakes the rest",
+           transfers == "a:00:55 a:01:55 a:02:55 b:08:55 a:03:55 a:04:55 a:05:55 a:06:55 a:07:55 ");
+
+    transfers.clear();
+    results = 0;
+    I2CTransaction background = transaction(0x10, 0x09, I2C_PRIORITY_LOW);
+    background.callback = countResult;
+    I2CQueue.submit(background);
+    uint64_t startNs = sim::nowNs();
+    I2CQueue.poll();
+    expect("poll starts without waiting", transfers == "a:09:55 " && sim::nowNs() == startNs &&
+           results == 0 && !I2CQueue.empty());
+    I2CQueue.loop(I2C_PRIORITY_MEDIUM);
+    expect("lower priority runs in the background", sim::nowNs() == startNs && results == 0);
+    I2CQueue.loop();
+    expect("callback after the transfer", sim::nowNs() > startNs && results == 1 && I2CQueue.empty());
+
+    FailingPanel panel;
+    Wire.attach(0x3C, &panel);
+    Display display(0x3C);
+    display.begin();
+    display.update();
+    display.fillRectangle(0, 0, 100, 32);
+    panel.failAfter(2);
+    display.flush();
+    I2CQueue.loop();
+    size_t frameSize = SimSSD1306::WIDTH * SimSSD1306::PAGES;
+    expect("failed chunk ends the transfer", !display.busy() &&
+           memcmp(panel.ram(), display.buffer(), frameSize) != 0);
+    uint32_t dataBytes = panel.dataBytes();
+    display.flush();
+    I2CQueue.loop();
+    expect("next flush sends the whole frame", panel.dataBytes() - dataBytes == frameSize &&
+           memcmp(panel.ram(), display.buffer(), frameSize) == 0);
+
+    ShortSlave shortSlave;
+    Wire.attach(0x29, &shortSlave);
+    RegisterReader full(0x10);
+    RegisterReader partial(0x29);
+    uint8_t registers[4];
+    expect("complete register read", full.readRegisters16(0x0102, registers, 4));
+    expect("short register read fails", !partial.readRegisters16(0x0102, registers, 4));
+
+    transfers.clear();
+    results = 0;
+    I2CQueue.submit(background);
+    I2CQueue.poll();
+    full.readRegisters16(0x0102, registers, 4);
+    expect("blocking access after the transfer", transfers == "a:09:55 a:01:02 a? " && results == 0);
+    I2CQueue.loop();
+    expect("leaves the callback to the queue", results == 1);
+
+    printf("\n%s\n", ok ? "ok" : "FAILED");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,414 @@
+/*
+ * Copyright (C) 2026 by Stefan Rothe
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <new>
+#include "sim.h"
+#include "devices.h"
+#include "trace.h"
+#include "smart_ball.h"
+#include "smart_glove.h"
+#include "config.h"
+#include "i2c_queue.h"
+#include "storage.h"
+
+/******************************************************************************
+ * allocation tracking
+ *****************************************************************************/
+
+void* operator new(size_t size) {
+    ++sim::stats.allocations;
+    sim::stats.allocatedBytes += size;
+    void* result = malloc(size == 0 ? 1 : size);
+    if (result == NULL) {
+        throw std::bad_alloc();
+    }
+
+    return result;
+}
+
+void* operator new[](size_t size) {
+    return operator new(size);
+}
+
+void operator delete(void* p) noexcept {
+    free(p);
+}
+
+void operator delete[](void* p) noexcept {
+    free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    free(p);
+}
+
+void operator delete[](void* p, size_t) noexcept {
+    free(p);
+}
+
+/******************************************************************************
+ * simulated hardware
+ *****************************************************************************/
+
+const uint8_t GLOVE_BUTTON_MAP[8] = {
+    BUTTON_INDEX_FINGER_1, BUTTON_MIDDLE_FINGER_1, BUTTON_RING_FINGER_1, BUTTON_LITTLE_FINGER_1,
+    BUTTON_THUMB_4, BUTTON_THUMB_3, BUTTON_THUMB_2, BUTTON_THUMB_1
+};
+
+const uint8_t BALL_BUTTON_MAP[7] = {
+    BUTTON_THUMB_1, BUTTON_INDEX_FINGER_1, BUTTON_MIDDLE_FINGER_1, BUTTON_RING_FINGER_1,
+    BUTTON_LITTLE_FINGER_1, BUTTON_INDEX_FINGER_2, BUTTON_MIDDLE_FINGER_2
+};
+
+const uint8_t FLEX_PINS[4] = {
+    INDEX_FINGER_FLEX_PIN, MIDDLE_FINGER_FLEX_PIN, RING_FINGER_FLEX_PIN, LITTLE_FINGER_FLEX_PIN
+};
+
+SimBNO055 imuChip;
+SimEEPROM eepromChip;
+SimPCA9557 sideButtonChip;
+SimPCA9557 tipButtonChip;
+SimSSD1306 displayChip;
+SimVL53L1X distanceChip;
+
+void attachDevices(bool ball, bool distanceInterrupt) {
+    Wire.attach(I2C_IMU_ADDRESS, &imuChip);
+    Wire.attach(0x50, &eepromChip);
+    Wire.attach(I2C_DISPLAY_ADDRESS, &displayChip);
+    if (ball) {
+        Wire.attach(I2C_SMART_BALL_BUTTONS_ADDRESS, &tipButtonChip);
+    }
+    else {
+        Wire.attach(I2C_SMART_GLOVE_SIDE_BUTTONS_ADDRESS, &sideButtonChip);
+        Wire.attach(I2C_SMART_GLOVE_TIP_BUTTONS_ADDRESS, &tipButtonChip);
+        Wire.attach(I2C_DISTANCE_ADDRESS, &distanceChip);
+        // pulled up by the firmware while not driven
+        sim::digitalInputs[DISTANCE_INTERRUPT_PIN] = HIGH;
+        if (distanceInterrupt) {
+            distanceChip.setInterruptPin(DISTANCE_INTERRUPT_PIN);
+        }
+    }
+}
+
+void applySample(const TraceSample& sample, bool ball) {
+    if (ball) {
+        uint8_t buttons = 0;
+        for (uint8_t bit = 0; bit < 7; ++bit) {
+            if (sample.buttons & (1 << BALL_BUTTON_MAP[bit])) {
+                buttons |= 1 << bit;
+            }
+        }
+
+        tipButtonChip.setInput(buttons);
+    }
+    else {
+        uint8_t side = 0;
+        uint8_t tip = 0;
+        for (uint8_t bit = 0; bit < 8; ++bit) {
+            if (sample.buttons & (1 << GLOVE_BUTTON_MAP[bit])) {
+                if (bit < 4) {
+                    tip |= 1 << (bit + 4);
+                }
+                else {
+                    side |= 1 << bit;
+                }
+            }
+        }
+
+        sideButtonChip.setInput(side);
+        tipButtonChip.setInput(tip);
+        distanceChip.setDistance(sample.distance);
+    }
+
+    for (uint8_t i = 0; i < 4; ++i) {
+        sim::analogInputs[FLEX_PINS[i]] = sample.flex[i];
+    }
+
+    imuChip.setEuler(sample.heading, sample.pitch, sample.roll);
+    imuChip.setLinearAcceleration(sample.accel[0], sample.accel[1], sample.accel[2]);
+}
+
+/******************************************************************************
+ * main
+ *****************************************************************************/
+
+void printCalibration(uint8_t sensorId) {
+    if (Storage.calibrated(sensorId)) {
+        printf(" %d..%d", Storage.calibrationMin(sensorId), Storage.calibrationMax(sensorId));
+    }
+    else {
+        printf(" -");
+    }
+}
+
+void usage() {
+    fprintf(stderr,
+        "usage: smartglove_sim [options] TRACE\n"
+        "  --ball            simulate a SmartBall instead of a SmartGlove\n"
+        "  --protocol N      preset the protocol stored in EEPROM (0 junXion, 1 Max)\n"
+        "  --distance-profile N\n"
+        "                    preset the distance profile stored in EEPROM (0 short, 1 long,\n"
+        "                    2 zones)\n"
+        "  --input FILE      serial input script sent by the host\n"
+        "  --output FILE     write the serial output of the device to FILE\n"
+        "  --i2c-clock HZ    override the I2C bus clock set by the firmware\n"
+        "  --no-distance-irq leave GPIO1 of the distance sensor unconnected\n"
+        "  --serial-rate N   bytes per ms the host reads from the serial port\n"
+        "  --warm-boot       boot and run for a second first, so that the EEPROM\n"
+        "                    holds what the firmware stores at runtime\n"
+        "  --loops N         stop after N loop iterations\n"
+        "  --profile         print the loop phase timing recorded by the firmware\n");
+}
+
+int main(int argc, char** argv) {
+    bool ball = false;
+    bool distanceInterrupt = true;
+    int protocol = -1;
+    int distanceProfile = -1;
+    const char* inputPath = NULL;
+    const char* outputPath = NULL;
+    const char* tracePath = NULL;
+    unsigned long maxLoops = 0;
+    bool profile = false;
+    bool warmBoot = false;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--ball") {
+            ball = true;
+        }
+        else if (arg == "--protocol" && hasValue) {
+            protocol = atoi(argv[++i]);
+        }
+        else if (arg == "--distance-profile" && hasValue) {
+            distanceProfile = atoi(argv[++i]);
+        }
+        else if (arg == "--input" && hasValue) {
+            inputPath = argv[++i];
+        }
+        else if (arg == "--output" && hasValue) {
+            outputPath = argv[++i];
+        }
+        else if (arg == "--i2c-clock" && hasValue) {
+            sim::overrideI2CClock(atoi(argv[++i]));
+        }
+        else if (arg == "--serial-rate" && hasValue) {
+            Serial.setTxCapacity(atoi(argv[++i]));
+        }
+        else if (arg == "--no-distance-irq") {
+            distanceInterrupt = false;
+        }
+        else if (arg == "--loops" && hasValue) {
+            maxLoops = strtoul(argv[++i], NULL, 10);
+        }
+        else if (arg == "--warm-boot") {
+            warmBoot = true;
+        }
+        else if (arg == "--profile") {
+            profile = true;
+        }
+        else if (arg[0] != '-' && tracePath == NULL) {
+            tracePath = argv[i];
+        }
+        else {
+            usage();
+            return 2;
+        }
+    }
+
+    if (tracePath == NULL || distanceProfile >= DISTANCE_PROFILE_COUNT) {
+        usage();
+        return 2;
+    }
+
+    Trace trace;
+    if (!trace.load(tracePath)) {
+        fprintf(stderr, "cannot load trace %s\n", tracePath);
+        return 1;
+    }
+
+    SerialScript script;
+    if (inputPath != NULL && !script.load(inputPath)) {
+        fprintf(stderr, "cannot load serial input %s\n", inputPath);
+        return 1;
+    }
+
+    // ignore allocations made by the simulated hardware
+    sim::stats = sim::Stats();
+    attachDevices(ball, distanceInterrupt);
+    if (protocol >= 0 || distanceProfile >= 0) {
+        // store the settings through the firmware, the EEPROM holds records
+        Storage.begin();
+        if (protocol >= 0) {
+            Storage.setProtocol(static_cast<uint8_t>(protocol));
+        }
+
+        if (distanceProfile >= 0) {
+            Storage.setDistanceProfile(static_cast<uint8_t>(distanceProfile));
+        }
+
+        while (Storage.dirty()) {
+            Storage.loop();
+            I2CQueue.loop();
+            sim::advanceUs(100);
+        }
+    }
+
+    if (warmBoot) {
+        // the chips keep their state, the firmware starts over
+        applySample(trace.sampleAt(0), ball);
+        SmartDevice* previous = ball ? static_cast<SmartDevice*>(new SmartBall()) : new SmartGlove();
+        previous->setup();
+        uint64_t endNs = sim::nowNs() + 1000000000ull;
+        while (sim::nowNs() < endNs || Storage.dirty()) {
+            distanceChip.tick();
+            previous->loop();
+            sim::advanceUs(10);
+        }
+    }
+
+    uint32_t presetPageWrites = eepromChip.pageWrites();
+    uint64_t presetNs = sim::nowNs();
+    // the trace and the serial input start with the measured boot
+    unsigned long traceStartMs = warmBoot ? millis() : 0;
+
+    applySample(trace.sampleAt(0), ball);
+    SmartDevice* device = ball ? static_cast<SmartDevice*>(new SmartBall()) : new SmartGlove();
+    device->setup();
+    sim::Stats setupStats = sim::stats;
+    uint32_t setupDisplayBytes = displayChip.dataBytes();
+    uint32_t setupDisplayTransfers = displayChip.transfers();
+    uint32_t setupMeasurements = distanceChip.measurements();
+    uint32_t setupResultReads = distanceChip.resultReads();
+    uint64_t setupNs = sim::nowNs();
+
+    // keep the growth of the captured serial output out of the statistics
+    Serial.output().reserve(1 << 22);
+    std::vector<uint32_t> loopUs;
+    uint64_t loopAllocations = 0;
+    uint64_t loopAllocatedBytes = 0;
+    SerialMessage message;
+    while (millis() - traceStartMs <= trace.durationMs() && (maxLoops == 0 || loopUs.size() < maxLoops)) {
+        applySample(trace.sampleAt(millis() - traceStartMs), ball);
+        while (script.next(millis() - traceStartMs, message)) {
+            Serial.inject(message.data.data(), message.data.size());
+        }
+
+        uint64_t start = sim::nowNs();
+        uint32_t profiledLoops = device->profiler().loops();
+        uint64_t allocations = sim::stats.allocations;
+        uint64_t allocatedBytes = sim::stats.allocatedBytes;
+        // raises the interrupt of the distance sensor when it is due
+        distanceChip.tick();
+        device->loop();
+        loopAllocations += sim::stats.allocations - allocations;
+        loopAllocatedBytes += sim::stats.allocatedBytes - allocatedBytes;
+        // the model has no CPU time, make sure the clock always moves
+        sim::advanceUs(1);
+        if (device->profiler().loops() == profiledLoops) {
+            // the loop returned early because the next iteration is not due yet
+            sim::advanceUs(9);
+            continue;
+        }
+
+        loopUs.push_back(static_cast<uint32_t>((sim::nowNs() - start) / 1000));
+    }
+
+    if (outputPath != NULL) {
+        FILE* out = fopen(outputPath, "wb");
+        if (out == NULL) {
+            fprintf(stderr, "cannot write %s\n", outputPath);
+            return 1;
+        }
+
+        fwrite(Serial.output().data(), 1, Serial.output().size(), out);
+        fclose(out);
+    }
+
+    sim::Stats& s = sim::stats;
+    double seconds = (sim::nowNs() - setupNs) / 1e9;
+    size_t loops = loopUs.size();
+    std::vector<uint32_t> sorted(loopUs);
+    std::sort(sorted.begin(), sorted.end());
+    uint64_t total = 0;
+    for (size_t i = 0; i < loops; ++i) {
+        total += loopUs[i];
+    }
+
+    printf("device            %s\n", ball ? "SmartBall" : "SmartGlove");
+    printf("i2c clock         %u Hz\n", sim::i2cClock());
+    printf("setup time        %.1f ms\n", (setupNs - presetNs) / 1e6);
+    printf("simulated time    %.3f s\n", seconds);
+    printf("loops             %zu (%.1f Hz)\n", loops, seconds > 0 ? loops / seconds : 0.0);
+    if (loops > 0) {
+        printf("loop time         avg %llu us, min %u us, p50 %u us, p99 %u us, max %u us\n",
+            static_cast<unsigned long long>(total / loops), sorted.front(), sorted[loops / 2],
+            sorted[loops * 99 / 100], sorted.back());
+    }
+
+    printf("i2c               %llu transactions, %llu bytes, %.1f%% bus load, %llu nacks\n",
+        static_cast<unsigned long long>(s.i2cTransactions - setupStats.i2cTransactions),
+        static_cast<unsigned long long>(s.i2cBytes - setupStats.i2cBytes),
+        seconds > 0 ? (s.i2cBusNs - setupStats.i2cBusNs) / (seconds * 1e7) : 0.0,
+        static_cast<unsigned long long>(s.i2cNacks - setupStats.i2cNacks));
+    bool displayMatches = !device->display().ready() ||
+        memcmp(displayChip.ram(), device->display().buffer(), SimSSD1306::WIDTH * SimSSD1306::PAGES) == 0;
+    printf("display           %u transfers, %u bytes, %s\n", displayChip.transfers() - setupDisplayTransfers,
+        displayChip.dataBytes() - setupDisplayBytes, displayMatches ? "in sync" : "OUT OF SYNC");
+    printf("serial out        %llu bytes in %llu writes (%.0f bytes/s)\n",
+        static_cast<unsigned long long>(s.serialBytesOut - setupStats.serialBytesOut),
+        static_cast<unsigned long long>(s.serialWrites - setupStats.serialWrites),
+        seconds > 0 ? (s.serialBytesOut - setupStats.serialBytesOut) / seconds : 0.0);
+    printf("serial in         %llu bytes\n", static_cast<unsigned long long>(s.serialBytesIn));
+    if (!ball) {
+        printf("distance          %u measurements, %u read, %s, %lu rejected\n",
+            distanceChip.measurements() - setupMeasurements, distanceChip.resultReads() - setupResultReads,
+            sim::interruptHandlers[DISTANCE_INTERRUPT_PIN] != NULL ? "interrupt" : "polling",
+            static_cast<unsigned long>(device->sensorRejected(SENSOR_DISTANCE)));
+    }
+
+    printf("neopixel shows    %llu\n", static_cast<unsigned long long>(s.neoPixelShows - setupStats.neoPixelShows));
+    printf("eeprom writes     %u pages\n", eepromChip.pageWrites() - presetPageWrites);
+    if (Storage.calibrated(SENSOR_DISTANCE) || Storage.calibrated(SENSOR_FLEX_INDEX_FINGER)) {
+        // ranges saved in the Calibration menu
+        printf("calibration       flex");
+        for (uint8_t id = SENSOR_FLEX_INDEX_FINGER; id <= SENSOR_FLEX_LITTLE_FINGER; ++id) {
+            printCalibration(id);
+        }
+
+        printf(", distance");
+        printCalibration(SENSOR_DISTANCE);
+        printf("\n");
+    }
+
+    printf("allocations       setup %llu (%llu bytes), loop %llu (%llu bytes)\n",
+        static_cast<unsigned long long>(setupStats.allocations),
+        static_cast<unsigned long long>(setupStats.allocatedBytes),
+        static_cast<unsigned long long>(loopAllocations),
+        static_cast<unsigned long long>(loopAllocatedBytes));
+    if (profile) {
+        LoopProfiler& profiler = device->profiler();
+        printf("\n%-14s %10s %10s\n", "phase", "avg us", "max us");
+        for (uint8_t phase = 0; phase < LoopProfiler::PHASE_COUNT; ++phase) {
+            printf("%-14s %10u %10u\n", LoopProfiler::phaseName(phase),
+                profiler.average(phase), profiler.maximum(phase));
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,79 @@
+/*
+ * Copyright (C) 2026 by Stefan Rothe
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Host stand-in for the Adafruit BNO055 library. Like the original, it talks
+ * to the chip over Wire, so the simulated BNO055 is accessed register by
+ * register.
+ */
+
+#ifndef ADAFRUIT_BNO055_H
+#define ADAFRUIT_BNO055_H
+
+#include <Wire.h>
+#include <Adafruit_Sensor.h>
+
+namespace imu {
+
+template <uint8_t N> class Vector {
+public:
+    Vector() {
+        for (uint8_t i = 0; i < N; ++i) {
+            _p[i] = 0;
+        }
+    }
+
+    double& operator[](uint8_t i) { return _p[i]; }
+    double x() const { return _p[0]; }
+    double y() const { return _p[1]; }
+    double z() const { return _p[2]; }
+private:
+    double _p[N];
+};
+
+}
+
+class Adafruit_BNO055 {
+public:
+    typedef enum {
+        OPERATION_MODE_CONFIG = 0x00,
+        OPERATION_MODE_IMUPLUS = 0x08,
+        OPERATION_MODE_NDOF = 0x0C
+    } adafruit_bno055_opmode_t;
+
+    typedef enum {
+        VECTOR_ACCELEROMETER = 0x08,
+        VECTOR_MAGNETOMETER = 0x0E,
+        VECTOR_GYROSCOPE = 0x14,
+        VECTOR_EULER = 0x1A,
+        VECTOR_LINEARACCEL = 0x28,
+        VECTOR_GRAVITY = 0x2E
+    } adafruit_vector_type_t;
+
+    Adafruit_BNO055(int32_t sensorID = -1, uint8_t address = 0x28, TwoWire* theWire = &Wire);
+    bool begin(adafruit_bno055_opmode_t mode = OPERATION_MODE_NDOF);
+    bool getEvent(sensors_event_t* event);
+    imu::Vector<3> getVector(adafruit_vector_type_t type);
+private:
+    bool readLen(uint8_t reg, uint8_t* buffer, uint8_t length);
+    bool write8(uint8_t reg, uint8_t value);
+    uint8_t _address;
+    int32_t _sensorID;
+    TwoWire* _wire;
+};
+
+#endif
@@ -0,0 +1,51 @@
+/*
+ * Copyright (C) 2026 by Stefan Rothe
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Host stand-in for the Adafruit NeoPixel library. show() is charged with
+ * the time the bit-banged transmission keeps the CPU busy.
+ */
+
+#ifndef ADAFRUIT_NEOPIXEL_H
+#define ADAFRUIT_NEOPIXEL_H
+
+#include <Arduino.h>
+
+#define NEO_GRB ((1 << 6) | (1 << 4) | (0 << 2) | (2))
+#define NEO_KHZ800 0x0000
+
+typedef uint16_t neoPixelType;
+
+class Adafruit_NeoPixel {
+public:
+    Adafruit_NeoPixel(uint16_t n, int16_t pin, neoPixelType type);
+    ~Adafruit_NeoPixel();
+    void begin();
+    uint32_t getPixelColor(uint16_t n) const;
+    uint16_t numPixels() const { return _count; }
+    void setPixelColor(uint16_t n, uint32_t c);
+    void show();
+
+    static uint32_t Color(uint8_t r, uint8_t g, uint8_t b) {
+        return (static_cast<uint32_t>(r) << 16) | (static_cast<uint32_t>(g) << 8) | b;
+    }
+private:
+    uint16_t _count;
+    uint32_t* _pixels;
+};
+
+#endif
@@ -0,0 +1,47 @@
+/*
+ * Copyright (C) 2026 by Stefan Rothe
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Host stand-in for the Adafruit Unified Sensor event types.
+ */
+
+#ifndef ADAFRUIT_SENSOR_H
+#define ADAFRUIT_SENSOR_H
+
+#include <Arduino.h>
+
+typedef struct {
+    float x;
+    float y;
+    float z;
+} sensors_vec_t;
+
+typedef struct {
+    int32_t version;
+    int32_t sensor_id;
+    int32_t type;
+    int32_t reserved0;
+    int32_t timestamp;
+    union {
+        float data[4];
+        sensors_vec_t acceleration;
+        sensors_vec_t orientation;
+        sensors_vec_t gyro;
+    };
+} sensors_event_t;
+
+#endif
@@ -0,0 +1,115 @@
+/*
+ * Copyright (C) 2026 by Stefan Rothe
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Host stand-in for the subset of the Arduino core used by the firmware.
+ */
+
+#ifndef ARDUINO_H
+#define ARDUINO_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <cmath>
+#include <deque>
+#include <vector>
+
+using std::abs;
+
+#define HEX 16
+#define DEC 10
+
+#define A0 14
+#define A1 15
+#define A2 16
+#define A3 17
+
+#define INPUT 0x0
+#define OUTPUT 0x1
+#define INPUT_PULLUP 0x2
+
+#define LOW 0x0
+#define HIGH 0x1
+
+#define CHANGE 2
+#define FALLING 3
+#define RISING 4
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+
+int analogRead(uint8_t pin);
+void pinMode(uint8_t pin, uint8_t mode);
+int digitalRead(uint8_t pin);
+void digitalWrite(uint8_t pin, uint8_t value);
+
+// every digital pin is its own interrupt, see sim::setDigitalInput()
+#define digitalPinToInterrupt(pin) (pin)
+void attachInterrupt(uint8_t interrupt, void (*callback)(), uint8_t mode);
+void detachInterrupt(uint8_t interrupt);
+// interrupt handlers only run from sim::setDigitalInput(), between firmware calls
+inline void interrupts() {}
+inline void noInterrupts() {}
+
+/******************************************************************************
+ * class HostSerial
+ *****************************************************************************/
+
+class HostSerial {
+public:
+    HostSerial();
+    void begin(unsigned long baud);
+    void end();
+    operator bool() const { return _open; }
+    int available() const;
+    int availableForWrite() const;
+    int peek() const;
+    int read();
+    size_t write(uint8_t data);
+    size_t write(const uint8_t* data, size_t length);
+    size_t print(char c);
+    size_t print(const char* text);
+    size_t print(int value, int base = DEC) { return print(static_cast<long>(value), base); }
+    size_t print(unsigned int value, int base = DEC) { return print(static_cast<unsigned long>(value), base); }
+    size_t print(long value, int base = DEC);
+    size_t print(unsigned long value, int base = DEC);
+    size_t println();
+    size_t println(const char* text);
+    template <typename T> size_t println(T value, int base = DEC) { return print(value, base) + println(); }
+
+    // simulator side
+    void inject(const uint8_t* data, size_t length);
+    void setTxCapacity(int bytesPerMs);
+    std::vector<uint8_t>& output() { return _output; }
+private:
+    void refillTx();
+    bool _open;
+    std::deque<uint8_t> _input;
+    std::vector<uint8_t> _output;
+    int _txCapacity;
+    int _txFree;
+    unsigned long _txMs;
+};
+
+extern HostSerial Serial;
+extern HostSerial Serial1;
+
+#endif
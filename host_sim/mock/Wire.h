@@ -0,0 +1,82 @@
+/*
+ * Copyright (C) 2026 by Stefan Rothe
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Host stand-in for the Arduino Wire library. Transactions are routed to
+ * simulated I2C slaves and charged to the simulated clock.
+ */
+
+#ifndef WIRE_H
+#define WIRE_H
+
+#include <Arduino.h>
+
+#define WIRE_BUFFER_SIZE 256
+
+/******************************************************************************
+ * class I2CSlave
+ *****************************************************************************/
+
+class I2CSlave {
+public:
+    virtual ~I2CSlave() {}
+
+    /**
+     * Handles a write transaction. Returns false if the slave does not
+     * acknowledge.
+     */
+    virtual bool receive(const uint8_t* data, size_t length) = 0;
+
+    /**
+     * Handles a read transaction. Returns the number of bytes provided.
+     */
+    virtual size_t request(uint8_t* data, size_t length) = 0;
+};
+
+/******************************************************************************
+ * class TwoWire
+ *****************************************************************************/
+
+class TwoWire {
+public:
+    TwoWire();
+    void begin();
+    void setClock(uint32_t hz);
+    void beginTransmission(uint8_t address);
+    uint8_t endTransmission(bool stopBit = true);
+    uint8_t requestFrom(uint8_t address, size_t quantity, bool stopBit = true);
+    size_t write(uint8_t data);
+    size_t write(const uint8_t* data, size_t length);
+    int available() const;
+    int read();
+
+    // simulator side
+    void attach(uint8_t address, I2CSlave* slave);
+    I2CSlave* slave(uint8_t address) const { return _slaves[address & 0x7F]; }
+private:
+    I2CSlave* _slaves[128];
+    uint8_t _txAddress;
+    uint8_t _txBuffer[WIRE_BUFFER_SIZE];
+    size_t _txLength;
+    uint8_t _rxBuffer[WIRE_BUFFER_SIZE];
+    size_t _rxLength;
+    size_t _rxIndex;
+};
+
+extern TwoWire Wire;
+
+#endif
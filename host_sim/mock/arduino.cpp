@@ -0,0 +1,178 @@
+/*
+ * Copyright (C) 2026 by Stefan Rothe
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <Arduino.h>
+#include "../sim.h"
+
+unsigned long millis() {
+    return static_cast<unsigned long>(sim::nowNs() / 1000000);
+}
+
+unsigned long micros() {
+    return static_cast<unsigned long>(sim::nowNs() / 1000);
+}
+
+void delay(unsigned long ms) {
+    sim::advanceUs(static_cast<uint64_t>(ms) * 1000);
+}
+
+void delayMicroseconds(unsigned int us) {
+    sim::advanceUs(us);
+}
+
+int analogRead(uint8_t pin) {
+    ++sim::stats.analogReads;
+    sim::advanceUs(sim::ANALOG_READ_US);
+    return pin < sim::PIN_COUNT ? sim::analogInputs[pin] : 0;
+}
+
+void pinMode(uint8_t pin, uint8_t mode) {
+}
+
+int digitalRead(uint8_t pin) {
+    return pin < sim::PIN_COUNT ? sim::digitalInputs[pin] : LOW;
+}
+
+void digitalWrite(uint8_t pin, uint8_t value) {
+}
+
+void attachInterrupt(uint8_t interrupt, void (*callback)(), uint8_t mode) {
+    if (interrupt < sim::PIN_COUNT) {
+        sim::interruptHandlers[interrupt] = callback;
+        sim::interruptModes[interrupt] = mode;
+    }
+}
+
+void detachInterrupt(uint8_t interrupt) {
+    if (interrupt < sim::PIN_COUNT) {
+        sim::interruptHandlers[interrupt] = NULL;
+    }
+}
+
+/******************************************************************************
+ * class HostSerial
+ *****************************************************************************/
+
+HostSerial::HostSerial() :
+    _open(false),
+    _txCapacity(sim::SERIAL_BYTES_PER_MS),
+    _txFree(sim::SERIAL_BYTES_PER_MS),
+    _txMs(0) {
+}
+
+void HostSerial::begin(unsigned long baud) {
+    _open = true;
+}
+
+void HostSerial::end() {
+    _open = false;
+}
+
+int HostSerial::available() const {
+    return static_cast<int>(_input.size());
+}
+
+int HostSerial::availableForWrite() const {
+    return sim::SERIAL_AVAILABLE_FOR_WRITE;
+}
+
+int HostSerial::peek() const {
+    return _input.empty() ? -1 : _input.front();
+}
+
+int HostSerial::read() {
+    if (_input.empty()) {
+        return -1;
+    }
+
+    uint8_t result = _input.front();
+    _input.pop_front();
+    return result;
+}
+
+size_t HostSerial::write(uint8_t data) {
+    return write(&data, 1);
+}
+
+size_t HostSerial::write(const uint8_t* data, size_t length) {
+    ++sim::stats.serialWrites;
+    sim::advanceNs(sim::SERIAL_NS_PER_CALL);
+    for (size_t i = 0; i < length; ++i) {
+        refillTx();
+        while (_txFree == 0) {
+            // USB endpoint is full, block until the next frame
+            sim::advanceUs(1000 - micros() % 1000);
+            refillTx();
+        }
+
+        --_txFree;
+        _output.push_back(data[i]);
+        sim::advanceNs(sim::SERIAL_NS_PER_BYTE);
+    }
+
+    sim::stats.serialBytesOut += length;
+    return length;
+}
+
+size_t HostSerial::print(char c) {
+    return write(static_cast<uint8_t>(c));
+}
+
+size_t HostSerial::print(const char* text) {
+    return write(reinterpret_cast<const uint8_t*>(text), strlen(text));
+}
+
+size_t HostSerial::print(long value, int base) {
+    char text[24];
+    snprintf(text, sizeof(text), base == HEX ? "%lX" : "%ld", value);
+    return print(text);
+}
+
+size_t HostSerial::print(unsigned long value, int base) {
+    char text[24];
+    snprintf(text, sizeof(text), base == HEX ? "%lX" : "%lu", value);
+    return print(text);
+}
+
+size_t HostSerial::println() {
+    return print("\r\n");
+}
+
+size_t HostSerial::println(const char* text) {
+    return print(text) + println();
+}
+
+void HostSerial::inject(const uint8_t* data, size_t length) {
+    _input.insert(_input.end(), data, data + length);
+    sim::stats.serialBytesIn += length;
+}
+
+void HostSerial::setTxCapacity(int bytesPerMs) {
+    _txCapacity = bytesPerMs;
+    _txFree = bytesPerMs;
+}
+
+void HostSerial::refillTx() {
+    unsigned long now = millis();
+    if (now != _txMs) {
+        _txMs = now;
+        _txFree = _txCapacity;
+    }
+}
+
+HostSerial Serial;
+HostSerial Serial1;
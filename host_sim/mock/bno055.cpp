@@ -0,0 +1,113 @@
+/*
+ * Copyright (C) 2026 by Stefan Rothe
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <Adafruit_BNO055.h>
+
+#define BNO055_CHIP_ID_ADDR 0x00
+#define BNO055_OPR_MODE_ADDR 0x3D
+#define BNO055_SYS_TRIGGER_ADDR 0x3F
+#define BNO055_ID 0xA0
+
+Adafruit_BNO055::Adafruit_BNO055(int32_t sensorID, uint8_t address, TwoWire* theWire) :
+    _address(address),
+    _sensorID(sensorID),
+    _wire(theWire) {
+}
+
+bool Adafruit_BNO055::begin(adafruit_bno055_opmode_t mode) {
+    uint8_t id = 0;
+    readLen(BNO055_CHIP_ID_ADDR, &id, 1);
+    if (id != BNO055_ID) {
+        delay(1000);
+        readLen(BNO055_CHIP_ID_ADDR, &id, 1);
+        if (id != BNO055_ID) {
+            return false;
+        }
+    }
+
+    // reset and wait for the chip to come back, as the original does
+    write8(BNO055_OPR_MODE_ADDR, OPERATION_MODE_CONFIG);
+    delay(25);
+    write8(BNO055_SYS_TRIGGER_ADDR, 0x20);
+    delay(650);
+    write8(BNO055_OPR_MODE_ADDR, mode);
+    delay(20);
+    return true;
+}
+
+bool Adafruit_BNO055::getEvent(sensors_event_t* event) {
+    memset(event, 0, sizeof(sensors_event_t));
+    event->sensor_id = _sensorID;
+    event->timestamp = millis();
+    imu::Vector<3> euler = getVector(VECTOR_EULER);
+    event->orientation.x = euler.x();
+    event->orientation.y = euler.y();
+    event->orientation.z = euler.z();
+    return true;
+}
+
+imu::Vector<3> Adafruit_BNO055::getVector(adafruit_vector_type_t type) {
+    imu::Vector<3> result;
+    uint8_t buffer[6];
+    memset(buffer, 0, 6);
+    readLen(type, buffer, 6);
+    int16_t x = static_cast<int16_t>(buffer[0] | (buffer[1] << 8));
+    int16_t y = static_cast<int16_t>(buffer[2] | (buffer[3] << 8));
+    int16_t z = static_cast<int16_t>(buffer[4] | (buffer[5] << 8));
+    double scale = 1.0;
+    switch (type) {
+    case VECTOR_MAGNETOMETER:
+    case VECTOR_GYROSCOPE:
+    case VECTOR_EULER:
+        scale = 16.0;
+        break;
+    case VECTOR_ACCELEROMETER:
+    case VECTOR_LINEARACCEL:
+    case VECTOR_GRAVITY:
+        scale = 100.0;
+        break;
+    }
+
+    result[0] = x / scale;
+    result[1] = y / scale;
+    result[2] = z / scale;
+    return result;
+}
+
+bool Adafruit_BNO055::readLen(uint8_t reg, uint8_t* buffer, uint8_t length) {
+    _wire->beginTransmission(_address);
+    _wire->write(reg);
+    _wire->endTransmission();
+    _wire->requestFrom(_address, length);
+    for (uint8_t i = 0; i < length; ++i) {
+        int data = _wire->read();
+        if (data < 0) {
+            return false;
+        }
+
+        buffer[i] = static_cast<uint8_t>(data);
+    }
+
+    return true;
+}
+
+bool Adafruit_BNO055::write8(uint8_t reg, uint8_t value) {
+    _wire->beginTransmission(_address);
+    _wire->write(reg);
+    _wire->write(value);
+    return _wire->endTransmission() == 0;
+}
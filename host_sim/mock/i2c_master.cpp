@@ -0,0 +1,110 @@
+/*
+ * Copyright (C) 2026 by Stefan Rothe
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Host stand-in for the SERCOM transfers of I2CMaster. The simulated slave
+ * handles a transfer when it is started and the result is known right away,
+ * but the transfer is busy until its bus time has passed on the simulated
+ * clock. Only wait() advances the clock.
+ */
+
+#include <Wire.h>
+#include "../../smartglove_neo/i2c_master.h"
+#include "../sim.h"
+
+static uint64_t _endNs = 0;
+
+I2CMasterSingleton::I2CMasterSingleton() :
+    _address(0),
+    _data(NULL),
+    _length(0),
+    _headerLength(0),
+    _index(0),
+    _read(false),
+    _state(STATE_IDLE) {
+}
+
+void I2CMasterSingleton::begin() {
+}
+
+bool I2CMasterSingleton::busy() const {
+    return sim::nowNs() < _endNs;
+}
+
+bool I2CMasterSingleton::start(const I2CTransaction& transaction) {
+    if (busy()) {
+        return false;
+    }
+
+    _address = transaction.address;
+    _headerLength = 0;
+    if (transaction.regSize == 2) {
+        _header[_headerLength++] = static_cast<uint8_t>(transaction.reg >> 8);
+    }
+
+    _header[_headerLength++] = static_cast<uint8_t>(transaction.reg & 0xFF);
+    _data = transaction.data;
+    _length = transaction.length;
+    _read = transaction.read;
+    service();
+    return true;
+}
+
+void I2CMasterSingleton::wait() {
+    if (busy()) {
+        sim::advanceNs(_endNs - sim::nowNs());
+    }
+}
+
+void I2CMasterSingleton::abort() {
+}
+
+void I2CMasterSingleton::finish(bool success) {
+    _state = success ? STATE_DONE : STATE_FAILED;
+}
+
+void I2CMasterSingleton::interruptHandler() {
+}
+
+void I2CMasterSingleton::service() {
+    uint8_t buffer[WIRE_BUFFER_SIZE];
+    I2CSlave* slave = Wire.slave(_address);
+    memcpy(buffer, _header, _headerLength);
+    size_t length = _headerLength;
+    if (!_read) {
+        memcpy(buffer + length, _data, _length);
+        length += _length;
+    }
+
+    _endNs = sim::nowNs() + sim::recordI2C(length);
+    if (slave == NULL || !slave->receive(buffer, length)) {
+        ++sim::stats.i2cNacks;
+        finish(false);
+        return;
+    }
+
+    if (_read) {
+        // repeated start, counted as a transaction of its own like Wire does
+        _endNs += sim::recordI2C(_length);
+        finish(slave->request(_data, _length) == _length);
+        return;
+    }
+
+    finish(true);
+}
+
+I2CMasterSingleton I2CMaster;
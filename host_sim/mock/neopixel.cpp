@@ -0,0 +1,50 @@
+/*
+ * Copyright (C) 2026 by Stefan Rothe
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <Adafruit_NeoPixel.h>
+#include "../sim.h"
+
+Adafruit_NeoPixel::Adafruit_NeoPixel(uint16_t n, int16_t pin, neoPixelType type) :
+    _count(n),
+    _pixels(new uint32_t[n]) {
+    for (uint16_t i = 0; i < n; ++i) {
+        _pixels[i] = 0;
+    }
+}
+
+Adafruit_NeoPixel::~Adafruit_NeoPixel() {
+    delete[] _pixels;
+}
+
+void Adafruit_NeoPixel::begin() {
+}
+
+uint32_t Adafruit_NeoPixel::getPixelColor(uint16_t n) const {
+    return n < _count ? _pixels[n] : 0;
+}
+
+void Adafruit_NeoPixel::setPixelColor(uint16_t n, uint32_t c) {
+    if (n < _count) {
+        _pixels[n] = c;
+    }
+}
+
+void Adafruit_NeoPixel::show() {
+    ++sim::stats.neoPixelShows;
+    sim::advanceNs(static_cast<uint64_t>(_count) * sim::NEOPIXEL_NS_PER_PIXEL);
+    sim::advanceUs(sim::NEOPIXEL_LATCH_US);
+}
@@ -0,0 +1,108 @@
+/*
+ * Copyright (C) 2026 by Stefan Rothe
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <Wire.h>
+#include "../sim.h"
+
+TwoWire::TwoWire() :
+    _txAddress(0),
+    _txLength(0),
+    _rxLength(0),
+    _rxIndex(0) {
+    for (uint8_t i = 0; i < 128; ++i) {
+        _slaves[i] = NULL;
+    }
+}
+
+void TwoWire::begin() {
+}
+
+void TwoWire::setClock(uint32_t hz) {
+    sim::setI2CClock(hz);
+}
+
+void TwoWire::beginTransmission(uint8_t address) {
+    _txAddress = address & 0x7F;
+    _txLength = 0;
+}
+
+uint8_t TwoWire::endTransmission(bool stopBit) {
+    sim::chargeI2C(_txLength);
+    I2CSlave* slave = _slaves[_txAddress];
+    if (slave == NULL || !slave->receive(_txBuffer, _txLength)) {
+        ++sim::stats.i2cNacks;
+        return 2;
+    }
+
+    return 0;
+}
+
+uint8_t TwoWire::requestFrom(uint8_t address, size_t quantity, bool stopBit) {
+    if (quantity > WIRE_BUFFER_SIZE) {
+        quantity = WIRE_BUFFER_SIZE;
+    }
+
+    _rxIndex = 0;
+    _rxLength = 0;
+    I2CSlave* slave = _slaves[address & 0x7F];
+    if (slave == NULL) {
+        sim::chargeI2C(0);
+        ++sim::stats.i2cNacks;
+        return 0;
+    }
+
+    _rxLength = slave->request(_rxBuffer, quantity);
+    sim::chargeI2C(_rxLength);
+    return static_cast<uint8_t>(_rxLength);
+}
+
+size_t TwoWire::write(uint8_t data) {
+    if (_txLength >= WIRE_BUFFER_SIZE) {
+        return 0;
+    }
+
+    _txBuffer[_txLength] = data;
+    ++_txLength;
+    return 1;
+}
+
+size_t TwoWire::write(const uint8_t* data, size_t length) {
+    size_t result = 0;
+    while (result < length && write(data[result])) {
+        ++result;
+    }
+
+    return result;
+}
+
+int TwoWire::available() const {
+    return static_cast<int>(_rxLength - _rxIndex);
+}
+
+int TwoWire::read() {
+    if (_rxIndex >= _rxLength) {
+        return -1;
+    }
+
+    return _rxBuffer[_rxIndex++];
+}
+
+void TwoWire::attach(uint8_t address, I2CSlave* slave) {
+    _slaves[address & 0x7F] = slave;
+}
+
+TwoWire Wire;
@@ -0,0 +1,269 @@
+/*
+ * Copyright (C) 2026 by Stefan Rothe
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Checks the sensor acquisition of the firmware against the original double
+ * precision implementation, which scaled every sample in floating point and
+ * recomputed the sums over the whole ring buffer, and compares the run time
+ * of both on the host.
+ *
+ * Two properties are checked for every sample:
+ * - the Q16 scaled value differs by at most one from the double result
+ * - mean, variance and activity are identical to a full recomputation over
+ *   the last 16 scaled values
+ *
+ * usage: sensor_bench [TRACE...]
+ */
+
+#include <chrono>
+#include "trace.h"
+#include "../smartglove_neo/sensors.cpp"
+
+/******************************************************************************
+ * class ReferenceSensor
+ *****************************************************************************/
+
+class ReferenceSensor {
+public:
+    ReferenceSensor() :
+        _activity(false),
+        _activityThreshold(0),
+        _factor(1.0),
+        _mean(0),
+        _pos(0),
+        _rawMax(1.0),
+        _rawMin(-1.0),
+        _value(0x7FFF),
+        _variance(0) {
+        for (uint8_t i = 0; i < 16; ++i) {
+            _values[i] = 0x7FFF;
+        }
+    }
+
+    void configure(double min, double max, double minStdDev) {
+        _rawMin = min;
+        _rawMax = max;
+        _factor = static_cast<double>(0xFFFF) / (_rawMax - _rawMin);
+        _activityThreshold = minStdDev * abs(_factor);
+        _activityThreshold *= _activityThreshold;
+    }
+
+    void addMeasurement(unsigned long, double value) {
+        if (_rawMin < _rawMax) {
+            value = value < _rawMin ? _rawMin : value > _rawMax ? _rawMax : value;
+        }
+        else {
+            value = value > _rawMin ? _rawMin : value < _rawMax ? _rawMax : value;
+        }
+
+        addScaled((value - _rawMin) * _factor);
+    }
+
+    void addScaled(uint16_t currentValue) {
+        _pos = (_pos + 1) % 16;
+        _values[_pos] = currentValue;
+        uint64_t sum = 0;
+        uint64_t sumOfSquares = 0;
+        for (uint8_t i = 0; i < 16; ++i) {
+            uint64_t val = _values[i];
+            sum += val;
+            sumOfSquares += val * val;
+        }
+
+        _mean = sum / 16;
+        _variance = sumOfSquares / 16 - _mean * _mean;
+        _activity = _activityThreshold < _variance;
+        if (_activity) {
+            _value = currentValue;
+        }
+    }
+
+    void setActivityThreshold(uint64_t threshold) { _activityThreshold = threshold; }
+
+    bool _activity;
+    uint64_t _activityThreshold;
+    double _factor;
+    uint64_t _mean;
+    uint8_t _pos;
+    double _rawMax;
+    double _rawMin;
+    uint16_t _value;
+    uint16_t _values[16];
+    int64_t _variance;
+};
+
+/******************************************************************************
+ * input
+ *****************************************************************************/
+
+struct Channel {
+    const char* name;
+    // raw units per physical unit
+    int32_t lsb;
+    double min;
+    double max;
+    double minStdDev;
+};
+
+// same configuration as SmartDevice::setup() and SmartGlove::doSetup()
+const Channel CHANNELS[] = {
+    { "flex index", 1, 0, 500, 2.0 },
+    { "flex middle", 1, 0, 500, 2.0 },
+    { "flex ring", 1, 0, 500, 2.0 },
+    { "flex little", 1, 0, 500, 2.0 },
+    { "distance", 1, 0, 2000, 2.0 },
+    { "accel x", 100, -10.0, 10.0, 0.2 },
+    { "accel y", 100, 10.0, -10.0, 0.2 },
+    { "accel z", 100, 10.0, -10.0, 0.2 },
+    { "roll", 16, 180.0, -180.0, 2.0 },
+    { "pitch", 16, 90.0, -90.0, 1.0 },
+    { "heading", 16, 180.0, -180.0, 2.0 }
+};
+
+const size_t CHANNEL_COUNT = sizeof(CHANNELS) / sizeof(CHANNELS[0]);
+
+void addSample(std::vector<int32_t>* input, const TraceSample& sample) {
+    for (uint8_t i = 0; i < 4; ++i) {
+        input[i].push_back(sample.flex[i]);
+    }
+
+    if (sample.distance >= 0) {
+        input[4].push_back(sample.distance);
+    }
+
+    for (uint8_t i = 0; i < 3; ++i) {
+        input[5 + i].push_back(lround(sample.accel[i] * 100));
+    }
+
+    input[8].push_back(lround(sample.roll * 16));
+    input[9].push_back(lround(sample.pitch * 16));
+    input[10].push_back(lround((sample.heading > 180 ? sample.heading - 360 : sample.heading) * 16));
+}
+
+void configure(Sensor& sensor, const Channel& channel) {
+    sensor.configure(lround(channel.min * channel.lsb), lround(channel.max * channel.lsb),
+        lround(channel.minStdDev * channel.lsb));
+}
+
+/******************************************************************************
+ * main
+ *****************************************************************************/
+
+template <typename T, typename V>
+double measure(const std::vector<V>* input, T* sensors, unsigned passes) {
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    size_t samples = 0;
+    for (unsigned pass = 0; pass < passes; ++pass) {
+        for (size_t c = 0; c < CHANNEL_COUNT; ++c) {
+            for (size_t i = 0; i < input[c].size(); ++i) {
+                sensors[c].addMeasurement(0, input[c][i]);
+            }
+
+            samples += input[c].size();
+        }
+    }
+
+    std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+    return samples > 0 ? elapsed.count() / samples : 0;
+}
+
+int main(int argc, char** argv) {
+    std::vector<int32_t> input[CHANNEL_COUNT];
+    for (int i = 1; i < argc; ++i) {
+        Trace trace;
+        if (!trace.load(argv[i])) {
+            fprintf(stderr, "cannot load trace %s\n", argv[i]);
+            return 1;
+        }
+
+        // resample at the loop rate of the firmware
+        for (uint32_t ms = 0; ms <= trace.durationMs(); ms += 5) {
+            addSample(input, trace.sampleAt(ms));
+        }
+    }
+
+    // random values covering the whole range including clamping
+    srand(1);
+    for (size_t c = 0; c < CHANNEL_COUNT; ++c) {
+        double min = CHANNELS[c].min * CHANNELS[c].lsb;
+        double span = CHANNELS[c].max * CHANNELS[c].lsb - min;
+        for (unsigned i = 0; i < 20000; ++i) {
+            input[c].push_back(lround(min - span * 0.1 + span * 1.2 * rand() / RAND_MAX));
+        }
+    }
+
+    std::vector<double> physical[CHANNEL_COUNT];
+    for (size_t c = 0; c < CHANNEL_COUNT; ++c) {
+        for (size_t i = 0; i < input[c].size(); ++i) {
+            physical[c].push_back(static_cast<double>(input[c][i]) / CHANNELS[c].lsb);
+        }
+    }
+
+    bool ok = true;
+    printf("%-12s %8s %10s %10s %10s\n", "channel", "samples", "max error", "statistics", "activity");
+    for (size_t c = 0; c < CHANNEL_COUNT; ++c) {
+        Sensor sensor;
+        ReferenceSensor reference;
+        ReferenceSensor window;
+        configure(sensor, CHANNELS[c]);
+        reference.configure(CHANNELS[c].min, CHANNELS[c].max, CHANNELS[c].minStdDev);
+        // the firmware threshold is derived from the Q16 factor
+        uint32_t span = labs(lround((CHANNELS[c].max - CHANNELS[c].min) * CHANNELS[c].lsb));
+        uint64_t stdDev = (lround(CHANNELS[c].minStdDev * CHANNELS[c].lsb) * ((0xFFFFULL << 16) / span)) >> 16;
+        window.setActivityThreshold(stdDev * stdDev);
+        int maxError = 0;
+        unsigned long statisticMismatches = 0;
+        unsigned long activityMismatches = 0;
+        for (size_t i = 0; i < input[c].size(); ++i) {
+            sensor.addMeasurement(i * 5, input[c][i]);
+            reference.addMeasurement(0, physical[c][i]);
+            window.addScaled(sensor.lastValue());
+            int error = abs(static_cast<int>(sensor.lastValue()) - reference._values[reference._pos]);
+            maxError = std::max(maxError, error);
+            if (sensor.mean() != window._mean || sensor.variance() != window._variance ||
+                sensor.activity() != window._activity || sensor.value() != window._value) {
+                ++statisticMismatches;
+            }
+
+            if (sensor.activity() != reference._activity) {
+                ++activityMismatches;
+            }
+        }
+
+        printf("%-12s %8zu %10d %10lu %10lu\n", CHANNELS[c].name, input[c].size(), maxError,
+            statisticMismatches, activityMismatches);
+        ok = ok && maxError <= 1 && statisticMismatches == 0;
+    }
+
+    printf("\nmax error: largest difference of a scaled value to the double implementation\n"
+           "statistics: samples where mean, variance, activity or value differ from a full\n"
+           "            recomputation (must be 0)\n"
+           "activity: samples where activity differs from the double implementation\n");
+
+    Sensor sensors[CHANNEL_COUNT];
+    ReferenceSensor references[CHANNEL_COUNT];
+    for (size_t c = 0; c < CHANNEL_COUNT; ++c) {
+        configure(sensors[c], CHANNELS[c]);
+        references[c].configure(CHANNELS[c].min, CHANNELS[c].max, CHANNELS[c].minStdDev);
+    }
+
+    printf("\ndouble       %6.1f ns/sample\n", measure(physical, references, 20));
+    printf("fixed point  %6.1f ns/sample\n", measure(input, sensors, 20));
+    printf("(host timing, the SAMD21 has no FPU)\n");
+    printf("\n%s\n", ok ? "ok" : "FAILED");
+    return ok ? 0 : 1;
+}
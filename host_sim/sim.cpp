@@ -0,0 +1,79 @@
+/*
+ * Copyright (C) 2026 by Stefan Rothe
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "sim.h"
+#include <Arduino.h>
+
+namespace sim {
+
+Stats stats;
+int analogInputs[PIN_COUNT];
+uint8_t digitalInputs[PIN_COUNT];
+InterruptHandler interruptHandlers[PIN_COUNT];
+uint8_t interruptModes[PIN_COUNT];
+
+static uint64_t _nowNs = 0;
+static uint32_t _i2cClock = 100000;
+static uint32_t _i2cClockOverride = 0;
+
+uint64_t nowNs() {
+    return _nowNs;
+}
+
+void advanceNs(uint64_t ns) {
+    _nowNs += ns;
+}
+
+void setDigitalInput(uint8_t pin, uint8_t value) {
+    if (pin >= PIN_COUNT || digitalInputs[pin] == value) {
+        return;
+    }
+
+    digitalInputs[pin] = value;
+    uint8_t mode = interruptModes[pin];
+    if (interruptHandlers[pin] != NULL &&
+        (mode == CHANGE || (mode == FALLING && value == LOW) || (mode == RISING && value == HIGH))) {
+        interruptHandlers[pin]();
+    }
+}
+
+uint32_t i2cClock() {
+    return _i2cClockOverride != 0 ? _i2cClockOverride : _i2cClock;
+}
+
+void setI2CClock(uint32_t hz) {
+    _i2cClock = hz;
+}
+
+void overrideI2CClock(uint32_t hz) {
+    _i2cClockOverride = hz;
+}
+
+void chargeI2C(size_t bytes) {
+    advanceNs(recordI2C(bytes));
+}
+
+uint64_t recordI2C(size_t bytes) {
+    uint64_t bits = I2C_TRANSACTION_OVERHEAD_BITS + I2C_BITS_PER_BYTE * bytes;
+    uint64_t ns = bits * 1000000000ULL / i2cClock();
+    ++stats.i2cTransactions;
+    stats.i2cBytes += bytes;
+    stats.i2cBusNs += ns;
+    return ns;
+}
+
+}
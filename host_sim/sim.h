@@ -0,0 +1,93 @@
+/*
+ * Copyright (C) 2026 by Stefan Rothe
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SIM_H
+#define SIM_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+/******************************************************************************
+ * Simulated time and cost model
+ *
+ * The simulation has no notion of CPU time. The clock only advances when the
+ * firmware waits (delay) or uses a peripheral whose cost is modelled below.
+ * Loop times reported by the simulator are therefore bus and I/O times.
+ *****************************************************************************/
+
+namespace sim {
+
+// I2C: start + address byte + stop, and 9 bit times per data byte
+const uint32_t I2C_TRANSACTION_OVERHEAD_BITS = 20;
+const uint32_t I2C_BITS_PER_BYTE = 9;
+// ADC conversion with the default SAMD21 core settings
+const uint32_t ANALOG_READ_US = 20;
+// USB CDC: every write() call is its own bulk transfer, throughput is limited
+// to roughly 1 MB/s in practice
+const uint32_t SERIAL_NS_PER_CALL = 5000;
+const uint32_t SERIAL_NS_PER_BYTE = 100;
+const int SERIAL_BYTES_PER_MS = 1000;
+// the SAMD21 core reports the bulk endpoint size minus one as available for
+// write, whether the endpoint is free or not
+const int SERIAL_AVAILABLE_FOR_WRITE = 63;
+// WS2812 at 800 kHz, 24 bit per pixel plus 50 us latch
+const uint32_t NEOPIXEL_NS_PER_PIXEL = 30000;
+const uint32_t NEOPIXEL_LATCH_US = 50;
+
+struct Stats {
+    uint64_t i2cTransactions;
+    uint64_t i2cBytes;
+    uint64_t i2cBusNs;
+    uint64_t i2cNacks;
+    uint64_t serialBytesOut;
+    uint64_t serialBytesIn;
+    uint64_t serialWrites;
+    uint64_t analogReads;
+    uint64_t neoPixelShows;
+    uint64_t allocations;
+    uint64_t allocatedBytes;
+};
+
+extern Stats stats;
+
+uint64_t nowNs();
+void advanceNs(uint64_t ns);
+inline void advanceUs(uint64_t us) { advanceNs(us * 1000); }
+
+const uint8_t PIN_COUNT = 32;
+extern int analogInputs[PIN_COUNT];
+extern uint8_t digitalInputs[PIN_COUNT];
+// handlers attached by the firmware with attachInterrupt()
+typedef void (*InterruptHandler)();
+extern InterruptHandler interruptHandlers[PIN_COUNT];
+extern uint8_t interruptModes[PIN_COUNT];
+// drives a digital input like an external device, calls the attached
+// interrupt handler on a matching edge
+void setDigitalInput(uint8_t pin, uint8_t value);
+
+uint32_t i2cClock();
+void setI2CClock(uint32_t hz);
+// a non-zero clock takes precedence over the one set by the firmware
+void overrideI2CClock(uint32_t hz);
+void chargeI2C(size_t bytes);
+// counts a transaction without advancing the clock, returns its duration.
+// Used for transfers that run in the background.
+uint64_t recordI2C(size_t bytes);
+
+}
+
+#endif
@@ -0,0 +1,119 @@
+/*
+ * Copyright (C) 2026 by Stefan Rothe
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "trace.h"
+#include <fstream>
+#include <sstream>
+#include <stdio.h>
+#include <stdlib.h>
+
+/******************************************************************************
+ * class Trace
+ *****************************************************************************/
+
+bool Trace::load(const char* path) {
+    std::ifstream in(path);
+    if (!in) {
+        return false;
+    }
+
+    std::string line;
+    while (std::getline(in, line)) {
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+
+        TraceSample s;
+        unsigned int buttons;
+        int fields = sscanf(line.c_str(), "%u,%x,%d,%d,%d,%d,%d,%lf,%lf,%lf,%lf,%lf,%lf",
+            &s.ms, &buttons, &s.flex[0], &s.flex[1], &s.flex[2], &s.flex[3], &s.distance,
+            &s.accel[0], &s.accel[1], &s.accel[2], &s.heading, &s.pitch, &s.roll);
+        if (fields != 13) {
+            fprintf(stderr, "%s: invalid trace line '%s'\n", path, line.c_str());
+            return false;
+        }
+
+        s.buttons = static_cast<uint16_t>(buttons);
+        _samples.push_back(s);
+    }
+
+    return !_samples.empty();
+}
+
+uint32_t Trace::durationMs() const {
+    return _samples.empty() ? 0 : _samples.back().ms;
+}
+
+const TraceSample& Trace::sampleAt(uint32_t ms) const {
+    size_t lo = 0;
+    size_t hi = _samples.size();
+    while (hi - lo > 1) {
+        size_t mid = (lo + hi) / 2;
+        if (_samples[mid].ms <= ms) {
+            lo = mid;
+        }
+        else {
+            hi = mid;
+        }
+    }
+
+    return _samples[lo];
+}
+
+/******************************************************************************
+ * class SerialScript
+ *****************************************************************************/
+
+SerialScript::SerialScript() :
+    _next(0) {
+}
+
+bool SerialScript::load(const char* path) {
+    std::ifstream in(path);
+    if (!in) {
+        return false;
+    }
+
+    std::string line;
+    while (std::getline(in, line)) {
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+
+        std::istringstream fields(line);
+        SerialMessage message;
+        fields >> message.ms;
+        std::string byte;
+        while (fields >> byte) {
+            message.data.push_back(static_cast<uint8_t>(strtoul(byte.c_str(), NULL, 16)));
+        }
+
+        _messages.push_back(message);
+    }
+
+    return true;
+}
+
+bool SerialScript::next(uint32_t ms, SerialMessage& message) {
+    if (_next >= _messages.size() || _messages[_next].ms > ms) {
+        return false;
+    }
+
+    message = _messages[_next];
+    ++_next;
+    return true;
+}
@@ -0,0 +1,82 @@
+/*
+ * Copyright (C) 2026 by Stefan Rothe
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+/******************************************************************************
+ * Sensor trace
+ *
+ * A trace is a CSV file with one sample per line:
+ *
+ *   ms,buttons,flex0,flex1,flex2,flex3,distance,accel_x,accel_y,accel_z,heading,pitch,roll
+ *
+ * buttons is a hexadecimal mask of the BUTTON_* ids, flex values are raw ADC
+ * counts, distance is in mm (negative for no target), acceleration in m/s^2
+ * and orientation in degrees. Lines starting with '#' are ignored. A sample
+ * stays valid until the next sample.
+ *****************************************************************************/
+
+struct TraceSample {
+    uint32_t ms;
+    uint16_t buttons;
+    int flex[4];
+    int32_t distance;
+    double accel[3];
+    double heading;
+    double pitch;
+    double roll;
+};
+
+class Trace {
+public:
+    bool load(const char* path);
+    uint32_t durationMs() const;
+    const TraceSample& sampleAt(uint32_t ms) const;
+    size_t size() const { return _samples.size(); }
+    const TraceSample& operator[](size_t i) const { return _samples[i]; }
+private:
+    std::vector<TraceSample> _samples;
+};
+
+/******************************************************************************
+ * Serial input script
+ *
+ * One message per line: the time in ms followed by the bytes in hexadecimal,
+ * e.g. "100 FF FF 00 44".
+ *****************************************************************************/
+
+struct SerialMessage {
+    uint32_t ms;
+    std::vector<uint8_t> data;
+};
+
+class SerialScript {
+public:
+    SerialScript();
+    bool load(const char* path);
+    bool next(uint32_t ms, SerialMessage& message);
+private:
+    std::vector<SerialMessage> _messages;
+    size_t _next;
+};
+
+#endif
@@ -35,7 +35,7 @@ void MenuBehaviour::setup() {
 }
 
 void MenuBehaviour::loop() {
-    device.display().setFont(&HELVETICA_10);
+    device.display().setFont(&FONT_SMALL);
     device.display().setTextAlign(ALIGN_LEFT);
     if (device.commandEnter()) {
         action(_selected);
@@ -52,7 +52,9 @@ void MenuBehaviour::loop() {
         selected(_selected);
     }
 
-    draw(_selected);
+    if (device.renderFrame()) {
+        draw(_selected);
+    }
 }
 
 void MenuBehaviour::select(uint8_t index) {
@@ -76,18 +78,50 @@ void InitBehaviour::setup() {
 void InitBehaviour::loop() {
     uint8_t protocol = Storage.protocol();
     switch (protocol) {
-        case 0:
+        case PROTOCOL_JUNXION:
             device.pushBehaviour(new Junxion(device));
             break;
-        case 1:
+        case PROTOCOL_MAX:
             device.pushBehaviour(new Max(device));
             break;
         default:
-            Storage.setProtocol(0);
+            Storage.setProtocol(PROTOCOL_JUNXION);
             break;
     }
 }
 
+/******************************************************************************
+ * class ActivityOption
+ *****************************************************************************/
+
+const uint8_t ActivityOption::ITEM_COUNT = 5;
+const char* ActivityOption::ITEMS[ActivityOption::ITEM_COUNT] = {
+    "Very sensitive", "Sensitive", "Normal", "Insensitive", "Very insensitive"
+};
+const uint8_t ActivityOption::MAP[] = {
+    25, 50, 100, 150, 200
+};
+
+ActivityOption::ActivityOption(SmartDevice& device) :
+    MenuBehaviour(device, ITEM_COUNT) {
+    for (uint8_t i = 0; i < ITEM_COUNT; ++i) {
+        if (MAP[i] == Storage.activityScale()) {
+            select(i);
+        }
+    }
+}
+
+void ActivityOption::action(uint8_t selected) {
+    Storage.setActivityScale(MAP[selected]);
+    device.applyPresetSettings();
+    device.popBehaviour();
+}
+
+void ActivityOption::draw(uint8_t selected) {
+    device.display().drawText(10, 8, "Activity");
+    device.display().drawText(10, 20, ITEMS[selected]);
+}
+
 /******************************************************************************
  * class BoardIdSelect
  *****************************************************************************/
@@ -124,7 +158,7 @@ ButtonTest::ButtonTest(SmartDevice& device) :
 }
 
 void ButtonTest::setup() {
-    device.display().setFont(&HELVETICA_10);
+    device.display().setFont(&FONT_SMALL);
     device.display().setTextAlign(ALIGN_LEFT);
 }
 
@@ -177,6 +211,31 @@ void DebugSerialOption::draw(uint8_t selected) {
     device.display().drawText(10, 20, ITEMS[selected]);
 }
 
+/******************************************************************************
+ * class DistanceProfileOption
+ *****************************************************************************/
+
+const char* DistanceProfileOption::ITEMS[DISTANCE_PROFILE_COUNT] = {
+    "Short, 50 Hz",
+    "Long, 20 Hz",
+    "Zones, 3 x 17 Hz"
+};
+
+DistanceProfileOption::DistanceProfileOption(SmartDevice& device) :
+    MenuBehaviour(device, DISTANCE_PROFILE_COUNT) {
+    select(Storage.distanceProfile());
+}
+
+void DistanceProfileOption::action(uint8_t selected) {
+    Storage.setDistanceProfile(selected);
+    device.popBehaviour();
+}
+
+void DistanceProfileOption::draw(uint8_t selected) {
+    device.display().drawText(10, 8, "Distance Profile");
+    device.display().drawText(10, 20, ITEMS[selected]);
+}
+
 /******************************************************************************
  * class DistanceTest
  *****************************************************************************/
@@ -188,7 +247,7 @@ DistanceTest::DistanceTest(SmartDevice& device) :
 }
 
 void DistanceTest::setup() {
-    device.display().setFont(&HELVETICA_10);
+    device.display().setFont(&FONT_SMALL);
     device.display().setTextAlign(ALIGN_LEFT);
 }
 
@@ -197,7 +256,13 @@ void DistanceTest::loop() {
         device.popBehaviour();
     }
 
+    char text[16];
     device.display().drawText(10, 8, "Distance Test");
+    // failed measurements since the start
+    sprintf(text, "%lu rej.", static_cast<unsigned long>(device.sensorRejected(SENSOR_DISTANCE)));
+    device.display().setTextAlign(ALIGN_RIGHT);
+    device.display().drawText(120, 8, text);
+    device.display().setTextAlign(ALIGN_LEFT);
     device.display().drawRectangle(10, 22, RANGE, 8);
     uint16_t val = device.sensorValue(SENSOR_DISTANCE) / 565; // 565 = 65535 / RANGE
     if (device.debugSerial()) {
@@ -340,6 +405,38 @@ void GestureTest::draw(uint8_t selected) {
     }
 }
 
+/******************************************************************************
+ * class GestureTimeoutOption
+ *****************************************************************************/
+
+const uint8_t GestureTimeoutOption::ITEM_COUNT = 5;
+const char* GestureTimeoutOption::ITEMS[GestureTimeoutOption::ITEM_COUNT] = {
+    "150 ms", "300 ms", "500 ms", "750 ms", "1000 ms"
+};
+const uint16_t GestureTimeoutOption::MAP[] = {
+    150, 300, 500, 750, 1000
+};
+
+GestureTimeoutOption::GestureTimeoutOption(SmartDevice& device) :
+    MenuBehaviour(device, ITEM_COUNT) {
+    for (uint8_t i = 0; i < ITEM_COUNT; ++i) {
+        if (MAP[i] == Storage.gestureTimeoutMs()) {
+            select(i);
+        }
+    }
+}
+
+void GestureTimeoutOption::action(uint8_t selected) {
+    Storage.setGestureTimeoutMs(MAP[selected]);
+    device.applyPresetSettings();
+    device.popBehaviour();
+}
+
+void GestureTimeoutOption::draw(uint8_t selected) {
+    device.display().drawText(10, 8, "Gesture Timeout");
+    device.display().drawText(10, 20, ITEMS[selected]);
+}
+
 /******************************************************************************
  * class GyroscopeTest
  *****************************************************************************/
@@ -434,20 +531,51 @@ void LEDTest::selected(uint8_t selected) {
     }
 }
 
+/******************************************************************************
+ * class LoopTimingTest
+ *****************************************************************************/
+
+LoopTimingTest::LoopTimingTest(SmartDevice& device) :
+    MenuBehaviour(device, LoopProfiler::PHASE_COUNT) {
+}
+
+void LoopTimingTest::action(uint8_t selected) {
+    if (device.debugSerial()) {
+        device.profiler().print();
+    }
+
+    device.popBehaviour();
+}
+
+void LoopTimingTest::draw(uint8_t selected) {
+    char text[24];
+    device.display().drawText(10, 8, LoopProfiler::phaseName(selected));
+    sprintf(text, "%lu / %lu us",
+            static_cast<unsigned long>(device.profiler().average(selected)),
+            static_cast<unsigned long>(device.profiler().maximum(selected)));
+    device.display().drawText(10, 20, text);
+}
+
 /******************************************************************************
  * class MainMenu
  *****************************************************************************/
 
-const uint8_t MainMenu::ITEM_COUNT = 10;
+const uint8_t MainMenu::ITEM_COUNT = 16;
 const char* MainMenu::ITEMS[MainMenu::ITEM_COUNT] = {
+    "Preset",
     "Protocol",
     "junXion Board ID",
+    "Calibration",
+    "Activity",
+    "Gesture Timeout",
+    "Distance Profile",
     "Button Test",
     "LED Test",
     "Distance Test",
     "Gesture Test",
     "Gyroscope Test",
     "Flex Test",
+    "Loop Timing",
     "Debug Serial",
     "Exit"
 };
@@ -459,33 +587,51 @@ MainMenu::MainMenu(SmartDevice& device) :
 void MainMenu::action(uint8_t selected) {
     switch (selected) {
     case 0:
-        device.pushBehaviour(new ProtocolSelect(device));
+        device.pushBehaviour(new PresetSelect(device));
         break;
     case 1:
-        device.pushBehaviour(new BoardIdSelect(device));
+        device.pushBehaviour(new ProtocolSelect(device));
         break;
     case 2:
-        device.pushBehaviour(new ButtonTest(device));
+        device.pushBehaviour(new BoardIdSelect(device));
         break;
     case 3:
-        device.pushBehaviour(new LEDTest(device));
+        device.pushBehaviour(new SensorCalibration(device));
         break;
     case 4:
-        device.pushBehaviour(new DistanceTest(device));
+        device.pushBehaviour(new ActivityOption(device));
         break;
     case 5:
-        device.pushBehaviour(new GestureTest(device));
+        device.pushBehaviour(new GestureTimeoutOption(device));
         break;
     case 6:
-        device.pushBehaviour(new GyroscopeTest(device));
+        device.pushBehaviour(new DistanceProfileOption(device));
         break;
     case 7:
-        device.pushBehaviour(new FlexTest(device));
+        device.pushBehaviour(new ButtonTest(device));
         break;
     case 8:
-        device.pushBehaviour(new DebugSerialOption(device));
+        device.pushBehaviour(new LEDTest(device));
         break;
     case 9:
+        device.pushBehaviour(new DistanceTest(device));
+        break;
+    case 10:
+        device.pushBehaviour(new GestureTest(device));
+        break;
+    case 11:
+        device.pushBehaviour(new GyroscopeTest(device));
+        break;
+    case 12:
+        device.pushBehaviour(new FlexTest(device));
+        break;
+    case 13:
+        device.pushBehaviour(new LoopTimingTest(device));
+        break;
+    case 14:
+        device.pushBehaviour(new DebugSerialOption(device));
+        break;
+    case 15:
         device.popBehaviour();
         break;
     }
@@ -499,6 +645,27 @@ void MainMenu::draw(uint8_t selected) {
     device.display().setTextAlign(ALIGN_LEFT);
 }
 
+/******************************************************************************
+ * class PresetSelect
+ *****************************************************************************/
+
+PresetSelect::PresetSelect(SmartDevice& device) :
+    MenuBehaviour(device, STORAGE_PRESET_COUNT) {
+    select(Storage.preset());
+}
+
+void PresetSelect::action(uint8_t selected) {
+    device.selectPreset(selected);
+    device.popBehaviour();
+}
+
+void PresetSelect::draw(uint8_t selected) {
+    device.display().drawText(10, 8, "Preset");
+    char name[STORAGE_PRESET_NAME_SIZE];
+    Storage.presetName(selected, name);
+    device.display().drawText(10, 20, name);
+}
+
 /******************************************************************************
  * class ProtocolSelect
  *****************************************************************************/
@@ -523,3 +690,80 @@ void ProtocolSelect::draw(uint8_t selected) {
     device.display().drawText(10, 8, "Protocol");
     device.display().drawText(10, 20, ITEMS[selected]);
 }
+
+/******************************************************************************
+ * class SensorCalibration
+ *****************************************************************************/
+
+const uint8_t SensorCalibration::MAP[CALIBRATION_SENSOR_COUNT] = {
+    SENSOR_FLEX_INDEX_FINGER, SENSOR_FLEX_MIDDLE_FINGER, SENSOR_FLEX_RING_FINGER, SENSOR_FLEX_LITTLE_FINGER,
+    SENSOR_DISTANCE
+};
+
+// smallest range in raw units that replaces the default range
+const int32_t SensorCalibration::MIN_SPAN = 20;
+
+SensorCalibration::SensorCalibration(SmartDevice& device) :
+    Behaviour(device),
+    _sampled(0) {
+}
+
+void SensorCalibration::setup() {
+    device.display().setFont(&FONT_SMALL);
+    device.display().setTextAlign(ALIGN_LEFT);
+    _sampled = 0;
+}
+
+void SensorCalibration::loop() {
+    if (device.commandMenu()) {
+        // cancel
+        device.popBehaviour();
+        return;
+    }
+
+    uint8_t ready = 0;
+    for (uint8_t i = 0; i < CALIBRATION_SENSOR_COUNT; ++i) {
+        // the raw value of a failed distance measurement is a replacement
+        // that decays to the far end of the range, it must not widen it
+        if (device.sensorValid(MAP[i])) {
+            int32_t value = device.sensorRawValue(MAP[i]);
+            bool sampled = _sampled & (1 << i);
+            if (!sampled || value < _min[i]) {
+                _min[i] = value;
+            }
+
+            if (!sampled || value > _max[i]) {
+                _max[i] = value;
+            }
+
+            _sampled |= 1 << i;
+        }
+
+        if (calibrated(i)) {
+            ++ready;
+        }
+    }
+
+    if (device.commandEnter()) {
+        for (uint8_t i = 0; i < CALIBRATION_SENSOR_COUNT; ++i) {
+            if (calibrated(i)) {
+                device.calibrateSensor(MAP[i], _min[i], _max[i]);
+            }
+        }
+
+        device.popBehaviour();
+        return;
+    }
+
+    if (device.renderFrame()) {
+        char text[20];
+        device.display().drawText(10, 8, "Move all sensors");
+        sprintf(text, "%u ready, Enter saves", ready);
+        device.display().drawText(10, 20, text);
+    }
+}
+
+bool SensorCalibration::calibrated(uint8_t index) const {
+    return device.sensorAvailable(MAP[index]) && (_sampled & (1 << index)) &&
+           _max[index] - _min[index] >= MIN_SPAN;
+}
@@ -21,6 +21,8 @@
 #include "smart_device.h"
 #include "junxion.h"
 
+#define CALIBRATION_SENSOR_COUNT 5
+
 /******************************************************************************
  * class MenuBehaviour
  *****************************************************************************/
@@ -51,6 +53,21 @@ public:
     virtual void loop();
 };
 
+/******************************************************************************
+ * class ActivityOption
+ *****************************************************************************/
+
+class ActivityOption : public MenuBehaviour {
+public:
+    explicit ActivityOption(SmartDevice& device);
+    virtual void action(uint8_t selected);
+    virtual void draw(uint8_t selected);
+private:
+    static const uint8_t ITEM_COUNT;
+    static const char* ITEMS[];
+    static const uint8_t MAP[];
+};
+
 /******************************************************************************
  * class BoardIdSelect
  *****************************************************************************/
@@ -91,6 +108,19 @@ private:
     static const char* ITEMS[];
 };
 
+/******************************************************************************
+ * class DistanceProfileOption
+ *****************************************************************************/
+
+class DistanceProfileOption : public MenuBehaviour {
+public:
+    explicit DistanceProfileOption(SmartDevice& device);
+    virtual void action(uint8_t selected);
+    virtual void draw(uint8_t selected);
+private:
+    static const char* ITEMS[];
+};
+
 /******************************************************************************
  * class DistanceTest
  *****************************************************************************/
@@ -151,6 +181,21 @@ private:
     static const uint8_t MAP[];
 };
 
+/******************************************************************************
+ * class GestureTimeoutOption
+ *****************************************************************************/
+
+class GestureTimeoutOption : public MenuBehaviour {
+public:
+    explicit GestureTimeoutOption(SmartDevice& device);
+    virtual void action(uint8_t selected);
+    virtual void draw(uint8_t selected);
+private:
+    static const uint8_t ITEM_COUNT;
+    static const char* ITEMS[];
+    static const uint16_t MAP[];
+};
+
 /******************************************************************************
  * class GyroscopeTest
  *****************************************************************************/
@@ -184,6 +229,17 @@ private:
     static const char* ITEMS[];
 };
 
+/******************************************************************************
+ * class LoopTimingTest
+ *****************************************************************************/
+
+class LoopTimingTest : public MenuBehaviour {
+public:
+    explicit LoopTimingTest(SmartDevice& device);
+    virtual void action(uint8_t selected);
+    virtual void draw(uint8_t selected);
+};
+
 /******************************************************************************
  * class MainMenu
  *****************************************************************************/
@@ -198,6 +254,17 @@ private:
     static const char* ITEMS[];
 };
 
+/******************************************************************************
+ * class PresetSelect
+ *****************************************************************************/
+
+class PresetSelect : public MenuBehaviour {
+public:
+    explicit PresetSelect(SmartDevice& device);
+    virtual void action(uint8_t selected);
+    virtual void draw(uint8_t selected);
+};
+
 /******************************************************************************
  * class ProtocolSelect
  *****************************************************************************/
@@ -213,4 +280,23 @@ private:
     static const uint8_t MAP[];
 };
 
+/******************************************************************************
+ * class SensorCalibration
+ *****************************************************************************/
+
+class SensorCalibration : public Behaviour {
+public:
+    explicit SensorCalibration(SmartDevice& device);
+    virtual void setup();
+    virtual void loop();
+private:
+    static const uint8_t MAP[];
+    static const int32_t MIN_SPAN;
+    bool calibrated(uint8_t index) const;
+    int32_t _max[CALIBRATION_SENSOR_COUNT];
+    int32_t _min[CALIBRATION_SENSOR_COUNT];
+    // sensors with at least one valid sample
+    uint8_t _sampled;
+};
+
 #endif
@@ -22,6 +22,9 @@
 #define VERSION_MAJOR 6
 #define VERSION_MINOR 0
 
+// all devices on the bus support fast mode
+#define I2C_CLOCK_HZ 400000
+
 #define I2C_SMART_GLOVE_SIDE_BUTTONS_ADDRESS 0x18
 #define I2C_SMART_GLOVE_TIP_BUTTONS_ADDRESS  0x19
 #define I2C_SMART_BALL_BUTTONS_ADDRESS       0x19
@@ -34,11 +37,27 @@
 #define RING_FINGER_FLEX_PIN A2
 #define LITTLE_FINGER_FLEX_PIN A3
 
+// GPIO1 of the distance sensor, low while a measurement is ready. Boards
+// without this wire poll the sensor, see the README to enable it.
+#ifndef DISTANCE_INTERRUPT_PIN
+#define DISTANCE_INTERRUPT_PIN VL53L1X_NO_PIN
+#endif
+// failed distance measurements repeat the last valid distance for
+// DISTANCE_HOLD_MS, then move to the far end of the range within
+// DISTANCE_DECAY_MS. SENSOR_HOLD_FOREVER keeps the last valid distance.
+#define DISTANCE_HOLD_MS 250
+#define DISTANCE_DECAY_MS 500
+
 #define INDEX_FINGER_NEOPIXEL_PIN 18
 #define MIDDLE_FINGER_NEOPIXEL_PIN 19
 #define RING_FINGER_NEOPIXEL_PIN 11
 #define LITTLE_FINGER_NEOPIXEL_PIN 12
 
+// pixels per finger, fingers are numbered from 2 (index) to 5 (little)
+#define NEOPIXEL_COUNT 10
+#define NEOPIXEL_FIRST_FINGER 2
+#define NEOPIXEL_LAST_FINGER 5
+
 #define LONG_PRESS_MS 5000
 #define LED_BLINK_FAST_MS 100
 #define LED_BLINK_SLOW_MS 500
@@ -48,8 +67,25 @@
 
 #define BEHAVIOUR_STACK_CAPACITY 10
 
+// sensor acquisition and protocol output rate (200 Hz)
+#define LOOP_INTERVAL_US 5000
+// display refresh rate (20 Hz)
+#define DISPLAY_INTERVAL_MS 50
+// maximum NeoPixel refresh rate (50 Hz), 0 for no limit
+#define NEOPIXEL_INTERVAL_MS 20
+// display and EEPROM transfers stop this long before the next loop, about
+// the time of the longest display chunk
+#define I2C_BACKGROUND_MARGIN_US 1000
+
 #define SERIAL_CHECK_INTERVAL_MS 500
 
+// default output policy of the Max protocol, every loop as before the 'O'
+// message, the host can switch to send-on-change
+#define MAX_OUTPUT_INTERVAL_MS 0
+#define MAX_OUTPUT_ON_CHANGE false
+#define MAX_KEEP_ALIVE_MS 1000
+#define MAX_DEADBAND 32
+
 #define GESTURE_TIMEOUT_MS 300
 
 #ifdef DEBUG
@@ -0,0 +1,421 @@
+/*
+ * Copyright (C) 2026 by Stefan Rothe
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "display.h"
+#include "i2c_queue.h"
+
+#define COMMAND_COLUMN_ADDRESS 0x21
+#define COMMAND_PAGE_ADDRESS   0x22
+#define CONTROL_COMMAND        0x00
+#define CONTROL_DATA           0x40
+// data bytes per transmission, the Wire buffer also holds the control byte
+#define DATA_CHUNK 31
+#define GLYPH_FIRST ' '
+#define GLYPH_LAST  '~'
+#define GLYPH_WIDTH 5
+// the address commands of a page have not been sent yet
+#define NO_COLUMN 0xFF
+// horizontal advance of a space in unscaled pixels
+#define SPACE_WIDTH 3
+
+const Font FONT_SMALL = { 1, false };
+const Font FONT_LARGE = { 2, false };
+const Font FONT_HUGE = { 3, true };
+
+// SSD1306 setup for a 128x32 panel with internal charge pump and horizontal
+// addressing
+static const uint8_t INIT_SEQUENCE[] = {
+    0xAE,       // display off
+    0xD5, 0x80, // clock divide ratio
+    0xA8, 0x1F, // multiplex ratio, 32 lines
+    0xD3, 0x00, // display offset
+    0x40,       // start line 0
+    0x8D, 0x14, // charge pump on
+    0x20, 0x00, // horizontal addressing mode
+    0xA1,       // column 127 is mapped to SEG0
+    0xC8,       // scan from COM31 to COM0
+    0xDA, 0x02, // sequential COM pins
+    0x81, 0x8F, // contrast
+    0xD9, 0xF1, // precharge period
+    0xDB, 0x40, // VCOMH deselect level
+    0xA4,       // show RAM content
+    0xA6,       // normal, not inverted
+    0x2E,       // scrolling off
+    0xAF        // display on
+};
+
+// 5x7 pixel glyphs of the printable ASCII characters, one byte per column,
+// bit 0 is the top row
+static const uint8_t GLYPHS[GLYPH_LAST - GLYPH_FIRST + 1][GLYPH_WIDTH] = {
+    { 0x00, 0x00, 0x00, 0x00, 0x00 }, // ' '
+    { 0x00, 0x00, 0x5F, 0x00, 0x00 }, // '!'
+    { 0x00, 0x07, 0x00, 0x07, 0x00 }, // '"'
+    { 0x14, 0x7F, 0x14, 0x7F, 0x14 }, // '#'
+    { 0x24, 0x2A, 0x7F, 0x2A, 0x12 }, // '$'
+    { 0x23, 0x13, 0x08, 0x64, 0x62 }, // '%'
+    { 0x36, 0x49, 0x56, 0x20, 0x50 }, // '&'
+    { 0x00, 0x05, 0x03, 0x00, 0x00 }, // '\''
+    { 0x00, 0x1C, 0x22, 0x41, 0x00 }, // '('
+    { 0x00, 0x41, 0x22, 0x1C, 0x00 }, // ')'
+    { 0x14, 0x08, 0x3E, 0x08, 0x14 }, // '*'
+    { 0x08, 0x08, 0x3E, 0x08, 0x08 }, // '+'
+    { 0x00, 0x50, 0x30, 0x00, 0x00 }, // ','
+    { 0x08, 0x08, 0x08, 0x08, 0x08 }, // '-'
+    { 0x00, 0x60, 0x60, 0x00, 0x00 }, // '.'
+    { 0x20, 0x10, 0x08, 0x04, 0x02 }, // '/'
+    { 0x3E, 0x51, 0x49, 0x45, 0x3E }, // '0'
+    { 0x00, 0x42, 0x7F, 0x40, 0x00 }, // '1'
+    { 0x42, 0x61, 0x51, 0x49, 0x46 }, // '2'
+    { 0x21, 0x41, 0x45, 0x4B, 0x31 }, // '3'
+    { 0x18, 0x14, 0x12, 0x7F, 0x10 }, // '4'
+    { 0x27, 0x45, 0x45, 0x45, 0x39 }, // '5'
+    { 0x3C, 0x4A, 0x49, 0x49, 0x30 }, // '6'
+    { 0x01, 0x71, 0x09, 0x05, 0x03 }, // '7'
+    { 0x36, 0x49, 0x49, 0x49, 0x36 }, // '8'
+    { 0x06, 0x49, 0x49, 0x29, 0x1E }, // '9'
+    { 0x00, 0x36, 0x36, 0x00, 0x00 }, // ':'
+    { 0x00, 0x56, 0x36, 0x00, 0x00 }, // ';'
+    { 0x08, 0x14, 0x22, 0x41, 0x00 }, // '<'
+    { 0x14, 0x14, 0x14, 0x14, 0x14 }, // '='
+    { 0x00, 0x41, 0x22, 0x14, 0x08 }, // '>'
+    { 0x02, 0x01, 0x51, 0x09, 0x06 }, // '?'
+    { 0x32, 0x49, 0x79, 0x41, 0x3E }, // '@'
+    { 0x7E, 0x11, 0x11, 0x11, 0x7E }, // 'A'
+    { 0x7F, 0x49, 0x49, 0x49, 0x36 }, // 'B'
+    { 0x3E, 0x41, 0x41, 0x41, 0x22 }, // 'C'
+    { 0x7F, 0x41, 0x41, 0x22, 0x1C }, // 'D'
+    { 0x7F, 0x49, 0x49, 0x49, 0x41 }, // 'E'
+    { 0x7F, 0x09, 0x09, 0x09, 0x01 }, // 'F'
+    { 0x3E, 0x41, 0x49, 0x49, 0x7A }, // 'G'
+    { 0x7F, 0x08, 0x08, 0x08, 0x7F }, // 'H'
+    { 0x00, 0x41, 0x7F, 0x41, 0x00 }, // 'I'
+    { 0x20, 0x40, 0x41, 0x3F, 0x01 }, // 'J'
+    { 0x7F, 0x08, 0x14, 0x22, 0x41 }, // 'K'
+    { 0x7F, 0x40, 0x40, 0x40, 0x40 }, // 'L'
+    { 0x7F, 0x02, 0x0C, 0x02, 0x7F }, // 'M'
+    { 0x7F, 0x04, 0x08, 0x10, 0x7F }, // 'N'
+    { 0x3E, 0x41, 0x41, 0x41, 0x3E }, // 'O'
+    { 0x7F, 0x09, 0x09, 0x09, 0x06 }, // 'P'
+    { 0x3E, 0x41, 0x51, 0x21, 0x5E }, // 'Q'
+    { 0x7F, 0x09, 0x19, 0x29, 0x46 }, // 'R'
+    { 0x46, 0x49, 0x49, 0x49, 0x31 }, // 'S'
+    { 0x01, 0x01, 0x7F, 0x01, 0x01 }, // 'T'
+    { 0x3F, 0x40, 0x40, 0x40, 0x3F }, // 'U'
+    { 0x1F, 0x20, 0x40, 0x20, 0x1F }, // 'V'
+    { 0x3F, 0x40, 0x38, 0x40, 0x3F }, // 'W'
+    { 0x63, 0x14, 0x08, 0x14, 0x63 }, // 'X'
+    { 0x07, 0x08, 0x70, 0x08, 0x07 }, // 'Y'
+    { 0x61, 0x51, 0x49, 0x45, 0x43 }, // 'Z'
+    { 0x00, 0x7F, 0x41, 0x41, 0x00 }, // '['
+    { 0x02, 0x04, 0x08, 0x10, 0x20 }, // '\\'
+    { 0x00, 0x41, 0x41, 0x7F, 0x00 }, // ']'
+    { 0x04, 0x02, 0x01, 0x02, 0x04 }, // '^'
+    { 0x40, 0x40, 0x40, 0x40, 0x40 }, // '_'
+    { 0x00, 0x01, 0x02, 0x04, 0x00 }, // '`'
+    { 0x20, 0x54, 0x54, 0x54, 0x78 }, // 'a'
+    { 0x7F, 0x48, 0x44, 0x44, 0x38 }, // 'b'
+    { 0x38, 0x44, 0x44, 0x44, 0x20 }, // 'c'
+    { 0x38, 0x44, 0x44, 0x48, 0x7F }, // 'd'
+    { 0x38, 0x54, 0x54, 0x54, 0x18 }, // 'e'
+    { 0x08, 0x7E, 0x09, 0x01, 0x02 }, // 'f'
+    { 0x0C, 0x52, 0x52, 0x52, 0x3E }, // 'g'
+    { 0x7F, 0x08, 0x04, 0x04, 0x78 }, // 'h'
+    { 0x00, 0x44, 0x7D, 0x40, 0x00 }, // 'i'
+    { 0x20, 0x40, 0x44, 0x3D, 0x00 }, // 'j'
+    { 0x7F, 0x10, 0x28, 0x44, 0x00 }, // 'k'
+    { 0x00, 0x41, 0x7F, 0x40, 0x00 }, // 'l'
+    { 0x7C, 0x04, 0x18, 0x04, 0x78 }, // 'm'
+    { 0x7C, 0x08, 0x04, 0x04, 0x78 }, // 'n'
+    { 0x38, 0x44, 0x44, 0x44, 0x38 }, // 'o'
+    { 0x7C, 0x14, 0x14, 0x14, 0x08 }, // 'p'
+    { 0x08, 0x14, 0x14, 0x18, 0x7C }, // 'q'
+    { 0x7C, 0x08, 0x04, 0x04, 0x08 }, // 'r'
+    { 0x48, 0x54, 0x54, 0x54, 0x20 }, // 's'
+    { 0x04, 0x3F, 0x44, 0x40, 0x20 }, // 't'
+    { 0x3C, 0x40, 0x40, 0x20, 0x7C }, // 'u'
+    { 0x1C, 0x20, 0x40, 0x20, 0x1C }, // 'v'
+    { 0x3C, 0x40, 0x30, 0x40, 0x3C }, // 'w'
+    { 0x44, 0x28, 0x10, 0x28, 0x44 }, // 'x'
+    { 0x0C, 0x50, 0x50, 0x50, 0x3C }, // 'y'
+    { 0x44, 0x64, 0x54, 0x4C, 0x44 }, // 'z'
+    { 0x00, 0x08, 0x36, 0x41, 0x00 }, // '{'
+    { 0x00, 0x00, 0x7F, 0x00, 0x00 }, // '|'
+    { 0x00, 0x41, 0x36, 0x08, 0x00 }, // '}'
+    { 0x08, 0x04, 0x08, 0x10, 0x08 }  // '~'
+};
+
+static const uint8_t* glyph(char c) {
+    if (c < GLYPH_FIRST || c > GLYPH_LAST) {
+        c = '?';
+    }
+
+    return GLYPHS[c - GLYPH_FIRST];
+}
+
+// finds the columns of a glyph that contain pixels, glyphs are drawn
+// proportionally. Returns false for an empty glyph.
+static bool glyphColumns(const uint8_t* glyph, uint8_t& first, uint8_t& last) {
+    first = 0;
+    while (first < GLYPH_WIDTH && glyph[first] == 0) {
+        ++first;
+    }
+
+    if (first == GLYPH_WIDTH) {
+        return false;
+    }
+
+    last = GLYPH_WIDTH - 1;
+    while (glyph[last] == 0) {
+        --last;
+    }
+
+    return true;
+}
+
+Display::Display(uint8_t address) :
+    I2CDevice(address, I2C_PRIORITY_LOW),
+    _align(ALIGN_LEFT),
+    _busy(false),
+    _column(NO_COLUMN),
+    _font(&FONT_SMALL),
+    _page(PAGES),
+    _ready(false),
+    _valid(false) {
+    memset(_frame, 0, sizeof(_frame));
+}
+
+void Display::begin() {
+    _ready = present();
+    if (!_ready) {
+        return;
+    }
+
+    beginTransmission();
+    write(CONTROL_COMMAND);
+    for (uint8_t i = 0; i < sizeof(INIT_SEQUENCE); ++i) {
+        write(INIT_SEQUENCE[i]);
+    }
+
+    _ready = endTransmission();
+    if (_ready) {
+        clear();
+        update();
+    }
+}
+
+void Display::clear() {
+    memset(_frame, 0, sizeof(_frame));
+}
+
+void Display::drawRectangle(int16_t x, int16_t y, int16_t width, int16_t height) {
+    for (int16_t i = 0; i < width; ++i) {
+        setPixel(x + i, y);
+        setPixel(x + i, y + height - 1);
+    }
+
+    for (int16_t i = 0; i < height; ++i) {
+        setPixel(x, y + i);
+        setPixel(x + width - 1, y + i);
+    }
+}
+
+void Display::drawText(int16_t x, int16_t y, const char* text) {
+    if (_align == ALIGN_CENTER) {
+        x -= textWidth(text) / 2;
+    }
+    else if (_align == ALIGN_RIGHT) {
+        x -= textWidth(text);
+    }
+
+    uint8_t scale = _font->scale;
+    int16_t top = y - 4 * scale;
+    for (const char* c = text; *c != '\0'; ++c) {
+        const uint8_t* g = glyph(*c);
+        uint8_t first;
+        uint8_t last;
+        if (glyphColumns(g, first, last)) {
+            drawGlyph(x, top, first, last, g);
+            x += (last - first + 2) * scale + (_font->bold ? 1 : 0);
+        }
+        else {
+            x += SPACE_WIDTH * scale;
+        }
+    }
+}
+
+void Display::fillRectangle(int16_t x, int16_t y, int16_t width, int16_t height) {
+    for (int16_t i = 0; i < width; ++i) {
+        for (int16_t j = 0; j < height; ++j) {
+            setPixel(x + i, y + j);
+        }
+    }
+}
+
+void Display::flush() {
+    if (!ready() || busy()) {
+        return;
+    }
+
+    for (uint8_t page = 0; page < PAGES; ++page) {
+        const uint8_t* current = _frame + page * WIDTH;
+        uint8_t* shadow = _shadow + page * WIDTH;
+        uint8_t first = 0;
+        uint8_t last = WIDTH - 1;
+        // unchanged pages are marked by an empty range
+        _first[page] = 1;
+        _last[page] = 0;
+        if (_valid) {
+            while (first < WIDTH && current[first] == shadow[first]) {
+                ++first;
+            }
+
+            if (first == WIDTH) {
+                continue;
+            }
+
+            while (current[last] == shadow[last]) {
+                --last;
+            }
+        }
+
+        // the transfer is sent from the shadow buffer
+        memcpy(shadow + first, current + first, last - first + 1);
+        _first[page] = first;
+        _last[page] = last;
+    }
+
+    _valid = true;
+    _busy = true;
+    _page = 0;
+    _column = NO_COLUMN;
+    queueNext();
+}
+
+void Display::invalidate() {
+    _valid = false;
+}
+
+void Display::setFont(const Font* font) {
+    _font = font;
+}
+
+void Display::setTextAlign(TextAlign align) {
+    _align = align;
+}
+
+void Display::update() {
+    // finish a running transfer first
+    I2CQueue.loop();
+    invalidate();
+    flush();
+    I2CQueue.loop();
+}
+
+void Display::drawGlyph(int16_t x, int16_t top, uint8_t first, uint8_t last, const uint8_t* glyph) {
+    uint8_t scale = _font->scale;
+    uint8_t width = scale + (_font->bold ? 1 : 0);
+    for (uint8_t col = first; col <= last; ++col) {
+        for (uint8_t row = 0; row < 8; ++row) {
+            if (glyph[col] & (1 << row)) {
+                fillRectangle(x + (col - first) * scale, top + row * scale, width, scale);
+            }
+        }
+    }
+}
+
+void Display::queueNext() {
+    // one transaction at a time, the next one is queued when it has completed
+    while (_page < PAGES && _first[_page] > _last[_page]) {
+        ++_page;
+    }
+
+    if (_page >= PAGES) {
+        _busy = false;
+        return;
+    }
+
+    bool queued;
+    if (_column == NO_COLUMN) {
+        _command[0] = COMMAND_COLUMN_ADDRESS;
+        _command[1] = _first[_page];
+        _command[2] = _last[_page];
+        _command[3] = COMMAND_PAGE_ADDRESS;
+        _command[4] = _page;
+        _command[5] = _page;
+        queued = queueWrite(CONTROL_COMMAND, 1, _command, 6, transferred, this);
+        _column = _first[_page];
+    }
+    else {
+        uint8_t length = _last[_page] - _column + 1;
+        if (length > DATA_CHUNK) {
+            length = DATA_CHUNK;
+        }
+
+        queued = queueWrite(CONTROL_DATA, 1, _shadow + _page * WIDTH + _column, length, transferred, this);
+        if (_last[_page] - _column < DATA_CHUNK) {
+            ++_page;
+            _column = NO_COLUMN;
+        }
+        else {
+            _column += length;
+        }
+    }
+
+    if (!queued) {
+        // send everything with the next flush
+        _busy = false;
+        _valid = false;
+    }
+}
+
+void Display::setPixel(int16_t x, int16_t y) {
+    if (x < 0 || x >= WIDTH || y < 0 || y >= HEIGHT) {
+        return;
+    }
+
+    _frame[(y / 8) * WIDTH + x] |= 1 << (y % 8);
+}
+
+int16_t Display::textWidth(const char* text) const {
+    int16_t width = 0;
+    for (const char* c = text; *c != '\0'; ++c) {
+        uint8_t first;
+        uint8_t last;
+        if (glyphColumns(glyph(*c), first, last)) {
+            width += (last - first + 2) * _font->scale + (_font->bold ? 1 : 0);
+        }
+        else {
+            width += SPACE_WIDTH * _font->scale;
+        }
+    }
+
+    // no spacing after the last glyph
+    return width > _font->scale ? width - _font->scale : width;
+}
+
+void Display::transferred(void* context, bool success) {
+    Display* self = static_cast<Display*>(context);
+    if (!success) {
+        // the shadow buffer holds data the panel has not received, send
+        // everything with the next flush
+        self->_busy = false;
+        self->_valid = false;
+        return;
+    }
+
+    self->queueNext();
+}
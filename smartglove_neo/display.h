@@ -0,0 +1,125 @@
+/*
+ * Copyright (C) 2026 by Stefan Rothe
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef DISPLAY_H
+#define DISPLAY_H
+
+#include <Arduino.h>
+#include "i2cdevice.h"
+
+enum TextAlign {
+    ALIGN_LEFT, ALIGN_CENTER, ALIGN_RIGHT
+};
+
+/**
+ * The built-in 5x7 pixel font, scaled by an integer factor. Bold text is
+ * drawn twice, shifted by one pixel.
+ */
+struct Font {
+    uint8_t scale;
+    bool bold;
+};
+
+extern const Font FONT_SMALL;
+extern const Font FONT_LARGE;
+extern const Font FONT_HUGE;
+
+/******************************************************************************
+ * class Display
+ *****************************************************************************/
+
+class Display : private I2CDevice {
+public:
+    static const uint8_t WIDTH = 128;
+    static const uint8_t HEIGHT = 32;
+    static const uint8_t PAGES = HEIGHT / 8;
+
+    Display(uint8_t address);
+
+    /**
+     * Initializes the SSD1306 controller and clears the panel. ready() is
+     * false if the display did not acknowledge.
+     */
+    void begin();
+
+    /**
+     * Returns the frame buffer, WIDTH bytes per page. Bit 0 of a byte is the
+     * topmost pixel of the page.
+     */
+    inline const uint8_t* buffer() const { return _frame; }
+
+    /**
+     * Returns true while the transfer started by the last flush is running.
+     */
+    inline bool busy() const { return _busy; }
+
+    void clear();
+    void drawRectangle(int16_t x, int16_t y, int16_t width, int16_t height);
+
+    /**
+     * Draws text with the current font and alignment. x is the horizontal
+     * reference given by the alignment, y is the vertical center of the text.
+     */
+    void drawText(int16_t x, int16_t y, const char* text);
+    void fillRectangle(int16_t x, int16_t y, int16_t width, int16_t height);
+
+    /**
+     * Starts the transfer of the parts of the frame buffer that have changed
+     * since the last flush. For each page, only the column range between the
+     * first and the last changed column is sent. The transfer is queued in
+     * chunks with low priority, see I2CQueue, the frame buffer may be changed
+     * right away. Does nothing while busy.
+     */
+    void flush();
+    inline const Font* font() const { return _font; }
+
+    /**
+     * Marks the whole display as changed, the next flush transmits the
+     * complete frame buffer.
+     */
+    void invalidate();
+    inline bool ready() const { return _ready; }
+    void setFont(const Font* font);
+    void setTextAlign(TextAlign align);
+
+    /**
+     * Transmits the complete frame buffer and waits until it has been sent.
+     */
+    void update();
+private:
+    Display(const Display&);
+    Display& operator=(const Display&);
+    void drawGlyph(int16_t x, int16_t top, uint8_t first, uint8_t last, const uint8_t* glyph);
+    void queueNext();
+    void setPixel(int16_t x, int16_t y);
+    int16_t textWidth(const char* text) const;
+    static void transferred(void* context, bool success);
+    TextAlign _align;
+    bool _busy;
+    uint8_t _column;
+    uint8_t _command[6];
+    uint8_t _first[PAGES];
+    const Font* _font;
+    uint8_t _frame[WIDTH * PAGES];
+    uint8_t _last[PAGES];
+    uint8_t _page;
+    bool _ready;
+    uint8_t _shadow[WIDTH * PAGES];
+    bool _valid;
+};
+
+#endif
@@ -19,9 +19,8 @@
 #include "config.h"
 #include <Adafruit_NeoPixel.h>
 
-#define NEOPIXEL_COUNT 10
-
 Finger::Finger(uint8_t flexSensorPin, uint8_t neoPixelPin) :
+    _dirty(false),
     _flexSensorPin(flexSensorPin),
     _neopixel(new Adafruit_NeoPixel(NEOPIXEL_COUNT, neoPixelPin, NEO_GRB + NEO_KHZ800))
 {
@@ -30,12 +29,24 @@ Finger::Finger(uint8_t flexSensorPin, uint8_t neoPixelPin) :
 void Finger::init() {
   _neopixel->begin();
   fill(Adafruit_NeoPixel::Color(0, 0, 0));
+  _dirty = true;
+  showNeoPixels();
 }
 
-float Finger::readFlex() {
+uint16_t Finger::readFlex() {
     return analogRead(_flexSensorPin);
 }
 
+bool Finger::showNeoPixels() {
+    if (!_dirty) {
+        return false;
+    }
+
+    _neopixel->show();
+    _dirty = false;
+    return true;
+}
+
 void Finger::setNeoPixel(uint8_t index, uint8_t red, uint8_t green, uint8_t blue) {
     uint32_t color = Adafruit_NeoPixel::Color(red, green, blue);
     if (index == 0) {
@@ -44,15 +55,20 @@ void Finger::setNeoPixel(uint8_t index, uint8_t red, uint8_t green, uint8_t blue
     else {
         --index;
         if (index < NEOPIXEL_COUNT) {
-            _neopixel->setPixelColor(index, color);
+            setPixelColor(index, color);
         }
     }
-    _neopixel->show();
 }
 
 void Finger::fill(uint32_t color) {
     for (uint8_t i = 0; i < NEOPIXEL_COUNT; ++i) {
-        _neopixel->setPixelColor(i, color);
+        setPixelColor(i, color);
+    }
+}
+
+void Finger::setPixelColor(uint8_t index, uint32_t color) {
+    if (_neopixel->getPixelColor(index) != color) {
+        _neopixel->setPixelColor(index, color);
+        _dirty = true;
     }
-    _neopixel->show();
 }
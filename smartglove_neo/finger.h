@@ -30,12 +30,25 @@ class Finger {
 public:
     Finger(uint8_t flexSensorPin, uint8_t neoPixelPin);
     void init();
-    float readFlex();
+    uint16_t readFlex();
+
+    /**
+     * Transmits the pixel colors to the strip if they have changed since the
+     * last call. Returns true if the strip has been updated.
+     */
+    bool showNeoPixels();
+
+    /**
+     * Sets the color of a pixel. The change becomes visible with the next call
+     * to showNeoPixels().
+     */
     void setNeoPixel(uint8_t index, uint8_t red, uint8_t green, uint8_t blue);
 private:
+    bool _dirty;
     uint8_t _flexSensorPin;
     Adafruit_NeoPixel* _neopixel;
     void fill(uint32_t color);
+    void setPixelColor(uint8_t index, uint32_t color);
 };
 
 #endif
@@ -0,0 +1,175 @@
+/*
+ * Copyright (C) 2026 by Stefan Rothe
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "i2c_master.h"
+
+// the host simulation provides its own implementation, see host_sim
+#if defined(ARDUINO_ARCH_SAMD)
+
+// SERCOM of the Wire library on the Feather M0
+#define I2C_SERCOM SERCOM3
+
+#define COMMAND_READ 0x2
+#define COMMAND_STOP 0x3
+
+// the Wire library defines SERCOM3_Handler, the transfer interrupt is
+// installed in a copy of the vector table in RAM instead
+static DeviceVectors vectors __attribute__((aligned(256)));
+
+static inline void syncSystemOperation() {
+    while (I2C_SERCOM->I2CM.SYNCBUSY.reg & SERCOM_I2CM_SYNCBUSY_SYSOP) {
+    }
+}
+
+I2CMasterSingleton::I2CMasterSingleton() :
+    _address(0),
+    _data(NULL),
+    _length(0),
+    _headerLength(0),
+    _index(0),
+    _read(false),
+    _state(STATE_IDLE) {
+}
+
+void I2CMasterSingleton::begin() {
+    memcpy(&vectors, reinterpret_cast<const void*>(SCB->VTOR), sizeof(vectors));
+    vectors.pfnSERCOM3_Handler = reinterpret_cast<void*>(interruptHandler);
+    noInterrupts();
+    SCB->VTOR = reinterpret_cast<uint32_t>(&vectors);
+    __DSB();
+    interrupts();
+}
+
+bool I2CMasterSingleton::busy() const {
+    return _state == STATE_WRITE || _state == STATE_READ;
+}
+
+bool I2CMasterSingleton::start(const I2CTransaction& transaction) {
+    if (busy()) {
+        return false;
+    }
+
+    _address = transaction.address;
+    _headerLength = 0;
+    if (transaction.regSize == 2) {
+        _header[_headerLength++] = static_cast<uint8_t>(transaction.reg >> 8);
+    }
+
+    _header[_headerLength++] = static_cast<uint8_t>(transaction.reg & 0xFF);
+    _data = transaction.data;
+    _length = transaction.length;
+    _read = transaction.read;
+    _index = 0;
+    _state = STATE_WRITE;
+    I2C_SERCOM->I2CM.INTENSET.reg = SERCOM_I2CM_INTENSET_MB | SERCOM_I2CM_INTENSET_SB;
+    // the hardware waits for an idle bus before it sends the start condition
+    I2C_SERCOM->I2CM.ADDR.reg = SERCOM_I2CM_ADDR_ADDR(_address << 1);
+    syncSystemOperation();
+    return true;
+}
+
+void I2CMasterSingleton::wait() {
+    unsigned long start = micros();
+    while (busy()) {
+        if (micros() - start >= I2C_TRANSFER_TIMEOUT_US) {
+            abort();
+        }
+    }
+}
+
+void I2CMasterSingleton::abort() {
+    noInterrupts();
+    if (busy()) {
+        I2C_SERCOM->I2CM.INTENCLR.reg = SERCOM_I2CM_INTENCLR_MB | SERCOM_I2CM_INTENCLR_SB;
+        I2C_SERCOM->I2CM.CTRLB.reg |= SERCOM_I2CM_CTRLB_CMD(COMMAND_STOP);
+        syncSystemOperation();
+        // let Wire and the next transfer start from an idle bus
+        I2C_SERCOM->I2CM.STATUS.reg = SERCOM_I2CM_STATUS_BUSSTATE(1);
+        syncSystemOperation();
+        _state = STATE_FAILED;
+    }
+
+    interrupts();
+}
+
+void I2CMasterSingleton::finish(bool success) {
+    I2C_SERCOM->I2CM.INTENCLR.reg = SERCOM_I2CM_INTENCLR_MB | SERCOM_I2CM_INTENCLR_SB;
+    _state = success ? STATE_DONE : STATE_FAILED;
+}
+
+void I2CMasterSingleton::interruptHandler() {
+    I2CMaster.service();
+}
+
+void I2CMasterSingleton::service() {
+    SercomI2cm& i2c = I2C_SERCOM->I2CM;
+    uint8_t flags = i2c.INTFLAG.reg;
+    if (flags & SERCOM_I2CM_INTFLAG_MB) {
+        // an address or data byte has been sent
+        uint16_t status = i2c.STATUS.reg;
+        if (status & (SERCOM_I2CM_STATUS_ARBLOST | SERCOM_I2CM_STATUS_BUSERR)) {
+            // the bus is not ours, no stop condition
+            i2c.INTFLAG.reg = SERCOM_I2CM_INTFLAG_MB;
+            finish(false);
+        }
+        else if ((status & SERCOM_I2CM_STATUS_RXNACK) || _state != STATE_WRITE) {
+            i2c.CTRLB.reg |= SERCOM_I2CM_CTRLB_CMD(COMMAND_STOP);
+            syncSystemOperation();
+            finish(false);
+        }
+        else if (_index < _headerLength) {
+            i2c.DATA.reg = _header[_index];
+            ++_index;
+        }
+        else if (!_read && _index - _headerLength < _length) {
+            i2c.DATA.reg = _data[_index - _headerLength];
+            ++_index;
+        }
+        else if (_read) {
+            // repeated start for the data
+            _index = 0;
+            _state = STATE_READ;
+            i2c.ADDR.reg = SERCOM_I2CM_ADDR_ADDR((_address << 1) | 1);
+            syncSystemOperation();
+        }
+        else {
+            i2c.CTRLB.reg |= SERCOM_I2CM_CTRLB_CMD(COMMAND_STOP);
+            syncSystemOperation();
+            finish(true);
+        }
+    }
+    else if (flags & SERCOM_I2CM_INTFLAG_SB) {
+        // a data byte has been received, it is read before the acknowledge
+        // starts the next one
+        _data[_index] = i2c.DATA.reg;
+        ++_index;
+        if (_index < _length) {
+            i2c.CTRLB.reg = (i2c.CTRLB.reg & ~SERCOM_I2CM_CTRLB_ACKACT) | SERCOM_I2CM_CTRLB_CMD(COMMAND_READ);
+            syncSystemOperation();
+        }
+        else {
+            // not acknowledge the last byte, then stop
+            i2c.CTRLB.reg |= SERCOM_I2CM_CTRLB_ACKACT | SERCOM_I2CM_CTRLB_CMD(COMMAND_STOP);
+            syncSystemOperation();
+            finish(true);
+        }
+    }
+}
+
+I2CMasterSingleton I2CMaster;
+
+#endif
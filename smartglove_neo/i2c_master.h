@@ -0,0 +1,92 @@
+/*
+ * Copyright (C) 2026 by Stefan Rothe
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef I2C_MASTER_H
+#define I2C_MASTER_H
+
+#include "i2c_queue.h"
+
+// a transfer that has not completed after this time is aborted
+#define I2C_TRANSFER_TIMEOUT_US 5000
+
+/**
+ * Interrupt driven I2C master on the SERCOM of the Wire library. start()
+ * sends the start condition and returns, the SERCOM interrupt transfers the
+ * remaining bytes while the CPU continues. A register read sends the register
+ * address, then reads the data after a repeated start.
+ *
+ * The Wire library uses the same SERCOM. Direct Wire accesses must call
+ * wait() first, I2CDevice does this for its blocking accesses.
+ */
+class I2CMasterSingleton {
+public:
+    I2CMasterSingleton();
+
+    /**
+     * Installs the SERCOM interrupt handler. Wire.begin() must have been
+     * called before.
+     */
+    void begin();
+
+    /**
+     * Returns true while a transfer is running.
+     */
+    bool busy() const;
+
+    /**
+     * Starts the transfer of a transaction and returns immediately. The data
+     * buffer of the transaction must stay valid until the transfer has
+     * completed. Returns false if a transfer is running.
+     */
+    bool start(const I2CTransaction& transaction);
+
+    /**
+     * Returns true if the last completed transfer was acknowledged and
+     * returned all data requested.
+     */
+    inline bool success() const { return _state == STATE_DONE; }
+
+    /**
+     * Waits until the running transfer has completed. A transfer that takes
+     * longer than I2C_TRANSFER_TIMEOUT_US is aborted and fails.
+     */
+    void wait();
+private:
+    enum State {
+        STATE_IDLE, STATE_WRITE, STATE_READ, STATE_DONE, STATE_FAILED
+    };
+
+    I2CMasterSingleton(const I2CMasterSingleton&);
+    I2CMasterSingleton& operator=(const I2CMasterSingleton&);
+
+    void abort();
+    void finish(bool success);
+    static void interruptHandler();
+    void service();
+    uint8_t _address;
+    uint8_t* _data;
+    uint8_t _length;
+    uint8_t _header[2];
+    uint8_t _headerLength;
+    volatile uint8_t _index;
+    bool _read;
+    volatile State _state;
+};
+
+extern I2CMasterSingleton I2CMaster;
+
+#endif
@@ -0,0 +1,111 @@
+/*
+ * Copyright (C) 2026 by Stefan Rothe
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "i2c_queue.h"
+#include "i2c_master.h"
+
+I2CQueueSingleton::I2CQueueSingleton() :
+    _active(false),
+    _count(0),
+    _dropped(0) {
+}
+
+void I2CQueueSingleton::loop(uint8_t lowest, unsigned long budgetUs) {
+    unsigned long start = micros();
+    for (;;) {
+        complete();
+        if (budgetUs > 0 && micros() - start >= budgetUs) {
+            return;
+        }
+
+        startNext(lowest);
+        if (!pending(lowest) && !(_active && _current.priority <= lowest)) {
+            return;
+        }
+
+        I2CMaster.wait();
+    }
+}
+
+void I2CQueueSingleton::poll(uint8_t lowest) {
+    complete();
+    startNext(lowest);
+}
+
+bool I2CQueueSingleton::submit(const I2CTransaction& transaction) {
+    if (_count >= I2C_QUEUE_CAPACITY) {
+        ++_dropped;
+        return false;
+    }
+
+    _queue[_count] = transaction;
+    ++_count;
+    return true;
+}
+
+void I2CQueueSingleton::complete() {
+    if (!_active || I2CMaster.busy()) {
+        return;
+    }
+
+    // cleared before the callback, which may queue new transactions
+    _active = false;
+    if (_current.callback != NULL) {
+        _current.callback(_current.context, I2CMaster.success());
+    }
+}
+
+bool I2CQueueSingleton::pending(uint8_t lowest) const {
+    for (uint8_t i = 0; i < _count; ++i) {
+        if (_queue[i].priority <= lowest) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void I2CQueueSingleton::startNext(uint8_t lowest) {
+    if (_active || _count == 0) {
+        return;
+    }
+
+    // oldest transaction of the highest priority
+    uint8_t next = 0;
+    for (uint8_t i = 1; i < _count; ++i) {
+        if (_queue[i].priority < _queue[next].priority) {
+            next = i;
+        }
+    }
+
+    if (_queue[next].priority > lowest) {
+        return;
+    }
+
+    _current = _queue[next];
+    --_count;
+    for (uint8_t i = next; i < _count; ++i) {
+        _queue[i] = _queue[i + 1];
+    }
+
+    _active = I2CMaster.start(_current);
+    if (!_active && _current.callback != NULL) {
+        _current.callback(_current.context, false);
+    }
+}
+
+I2CQueueSingleton I2CQueue;
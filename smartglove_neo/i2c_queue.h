@@ -0,0 +1,113 @@
+/*
+ * Copyright (C) 2026 by Stefan Rothe
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef I2C_QUEUE_H
+#define I2C_QUEUE_H
+
+#include <Arduino.h>
+
+#define I2C_QUEUE_CAPACITY 16
+
+// priority classes, lower values are served first
+// buttons and IMU
+#define I2C_PRIORITY_HIGH   0
+// distance sensor
+#define I2C_PRIORITY_MEDIUM 1
+// display and EEPROM, transferred in chunks in the time left in a loop
+#define I2C_PRIORITY_LOW    2
+
+/**
+ * Called when a transaction has completed. success is false if the device
+ * did not acknowledge or returned less data than requested.
+ */
+typedef void (*I2CCallback)(void* context, bool success);
+
+/**
+ * A register read or write. The data buffer belongs to the caller and must
+ * stay valid until the transaction has completed.
+ */
+struct I2CTransaction {
+    uint8_t address;
+    I2CCallback callback;
+    void* context;
+    uint8_t* data;
+    uint8_t length;
+    uint8_t priority;
+    bool read;
+    uint16_t reg;
+    uint8_t regSize;
+};
+
+/**
+ * Transactions of all I2C devices that are accessed in the main loop. The
+ * devices queue their transactions and continue. The queue transfers them
+ * one at a time with I2CMaster, highest priority first and in order of
+ * submission within a priority. A transfer runs in the background, driven by
+ * the SERCOM interrupt, while the loop continues. Its callback is called by
+ * the next loop() or poll() after it has completed, never from an interrupt,
+ * and may queue further transactions.
+ *
+ * Blocking accesses through I2CDevice bypass the queue. They wait for the
+ * running transfer and are executed immediately, between queued transactions.
+ */
+class I2CQueueSingleton {
+public:
+    I2CQueueSingleton();
+
+    /**
+     * Returns the number of transactions rejected because the queue was full.
+     */
+    inline uint16_t dropped() const { return _dropped; }
+    inline bool empty() const { return _count == 0 && !_active; }
+
+    /**
+     * Transfers the queued transactions of priority lowest and above and
+     * waits until none are left, including the ones queued by callbacks. A
+     * running transfer of lower priority is waited for if it holds up one
+     * of them, otherwise it continues in the background. If budgetUs is not
+     * 0, no transaction is started once budgetUs have passed, the remaining
+     * ones stay queued for the next call.
+     */
+    void loop(uint8_t lowest = I2C_PRIORITY_LOW, unsigned long budgetUs = 0);
+
+    /**
+     * Calls the callback of a completed transfer and starts the next queued
+     * transaction of priority lowest and above. Does not wait for the bus.
+     */
+    void poll(uint8_t lowest = I2C_PRIORITY_LOW);
+
+    /**
+     * Adds a transaction to the queue. Returns false if the queue is full.
+     */
+    bool submit(const I2CTransaction& transaction);
+private:
+    I2CQueueSingleton(const I2CQueueSingleton&);
+    I2CQueueSingleton& operator=(const I2CQueueSingleton&);
+
+    void complete();
+    bool pending(uint8_t lowest) const;
+    void startNext(uint8_t lowest);
+    bool _active;
+    uint8_t _count;
+    I2CTransaction _current;
+    uint16_t _dropped;
+    I2CTransaction _queue[I2C_QUEUE_CAPACITY];
+};
+
+extern I2CQueueSingleton I2CQueue;
+
+#endif
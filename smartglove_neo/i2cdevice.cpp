@@ -0,0 +1,109 @@
+/*
+ * Copyright (C) 2026 by Stefan Rothe
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "i2cdevice.h"
+
+bool I2CDevice::queueRead(uint16_t reg, uint8_t regSize, uint8_t* data, uint8_t length,
+                          I2CCallback callback, void* context) const {
+    I2CTransaction transaction;
+    transaction.address = _address;
+    transaction.callback = callback;
+    transaction.context = context;
+    transaction.data = data;
+    transaction.length = length;
+    transaction.priority = _priority;
+    transaction.read = true;
+    transaction.reg = reg;
+    transaction.regSize = regSize;
+    return I2CQueue.submit(transaction);
+}
+
+bool I2CDevice::queueWrite(uint16_t reg, uint8_t regSize, const uint8_t* data, uint8_t length,
+                           I2CCallback callback, void* context) const {
+    I2CTransaction transaction;
+    transaction.address = _address;
+    transaction.callback = callback;
+    transaction.context = context;
+    // only read from for writes
+    transaction.data = const_cast<uint8_t*>(data);
+    transaction.length = length;
+    transaction.priority = _priority;
+    transaction.read = false;
+    transaction.reg = reg;
+    transaction.regSize = regSize;
+    return I2CQueue.submit(transaction);
+}
+
+bool I2CDevice::readRegisters16(uint16_t reg, uint8_t* data, uint8_t length) const {
+    bool result = true;
+    while (length > 0) {
+        uint8_t burst = length < I2C_BURST_SIZE ? length : I2C_BURST_SIZE;
+        beginTransmission();
+        write16(reg);
+        result = endTransmission() && result;
+        result = requestData(burst) && result;
+        for (uint8_t i = 0; i < burst; ++i) {
+            data[i] = read();
+        }
+
+        reg += burst;
+        data += burst;
+        length -= burst;
+    }
+
+    return result;
+}
+
+bool I2CDevice::writeRegisterList16(const I2CRegisterValue* list, uint8_t count) const {
+    bool result = true;
+    uint8_t i = 0;
+    while (i < count) {
+        beginTransmission();
+        write16(list[i].reg);
+        write(list[i].value);
+        uint8_t burst = 1;
+        ++i;
+        while (i < count && burst < I2C_BURST_SIZE && list[i].reg == list[i - 1].reg + 1) {
+            write(list[i].value);
+            ++burst;
+            ++i;
+        }
+
+        result = endTransmission() && result;
+    }
+
+    return result;
+}
+
+bool I2CDevice::writeRegisters16(uint16_t reg, const uint8_t* data, uint8_t length) const {
+    bool result = true;
+    while (length > 0) {
+        uint8_t burst = length < I2C_BURST_SIZE ? length : I2C_BURST_SIZE;
+        beginTransmission();
+        write16(reg);
+        for (uint8_t i = 0; i < burst; ++i) {
+            write(data[i]);
+        }
+
+        result = endTransmission() && result;
+        reg += burst;
+        data += burst;
+        length -= burst;
+    }
+
+    return result;
+}
@@ -20,11 +20,26 @@
 
 #include <Arduino.h>
 #include <Wire.h>
+#include "i2c_master.h"
+#include "i2c_queue.h"
+
+// bytes per transaction, the Wire buffer also holds a 16 bit register address
+#define I2C_BURST_SIZE 30
+
+struct I2CRegisterValue {
+    uint16_t reg;
+    uint8_t value;
+};
 
 class I2CDevice {
 public:
-    I2CDevice(uint8_t address) :
-      _address(address) {
+    /**
+     * priority is the class of all transactions the device queues, see
+     * I2CQueue.
+     */
+    I2CDevice(uint8_t address, uint8_t priority = I2C_PRIORITY_MEDIUM) :
+      _address(address),
+      _priority(priority) {
     }
 
     bool present() {
@@ -33,6 +48,8 @@ public:
     }
 protected:
     inline void beginTransmission() const {
+        // the bus is shared with the queued transfers
+        I2CMaster.wait();
         Wire.beginTransmission(_address);
     }
 
@@ -56,8 +73,8 @@ protected:
         return Wire.endTransmission() == 0;
     }
 
-    inline void requestData(uint8_t bytes) const {
-        Wire.requestFrom(_address, bytes);
+    inline bool requestData(uint8_t bytes) const {
+        return Wire.requestFrom(_address, bytes) == bytes;
     }
 
     inline uint8_t read() const {
@@ -69,8 +86,44 @@ protected:
         value |= Wire.read();
         return value;
     }
+
+    /**
+     * Queues a read of length consecutive registers starting at reg, see
+     * I2CQueue. regSize is the size of the register address in bytes.
+     */
+    bool queueRead(uint16_t reg, uint8_t regSize, uint8_t* data, uint8_t length,
+                   I2CCallback callback = NULL, void* context = NULL) const;
+
+    /**
+     * Queues a write of length consecutive registers starting at reg, see
+     * I2CQueue. regSize is the size of the register address in bytes.
+     */
+    bool queueWrite(uint16_t reg, uint8_t regSize, const uint8_t* data, uint8_t length,
+                    I2CCallback callback = NULL, void* context = NULL) const;
+
+    /**
+     * Reads length consecutive registers starting at the 16 bit register
+     * address reg. Longer ranges are split into bursts of I2C_BURST_SIZE.
+     * Returns false if the device did not acknowledge or returned less data
+     * than requested, the contents of data are undefined then.
+     */
+    bool readRegisters16(uint16_t reg, uint8_t* data, uint8_t length) const;
+
+    /**
+     * Writes a list of register/value pairs with 16 bit register addresses.
+     * Runs of entries with ascending consecutive registers are combined into
+     * one transaction, the order of the list is kept.
+     */
+    bool writeRegisterList16(const I2CRegisterValue* list, uint8_t count) const;
+
+    /**
+     * Writes length consecutive registers starting at the 16 bit register
+     * address reg. Longer ranges are split into bursts of I2C_BURST_SIZE.
+     */
+    bool writeRegisters16(uint16_t reg, const uint8_t* data, uint8_t length) const;
 private:
     uint8_t _address;
+    uint8_t _priority;
 };
 
 #endif
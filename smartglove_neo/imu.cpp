@@ -0,0 +1,52 @@
+/*
+ * Copyright (C) 2026 by Stefan Rothe
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "imu.h"
+
+#define REGISTER_EULER        0x1A
+#define REGISTER_LINEAR_ACCEL 0x28
+
+const int16_t IMU::ACCEL_LSB = 100;
+const int16_t IMU::EULER_LSB = 16;
+
+IMU::IMU(uint8_t address) :
+    I2CDevice(address, I2C_PRIORITY_HIGH) {
+    memset(_euler, 0, sizeof(_euler));
+    memset(_linearAcceleration, 0, sizeof(_linearAcceleration));
+}
+
+void IMU::euler(int16_t* result) const {
+    decodeVector(_euler, result);
+}
+
+void IMU::linearAcceleration(int16_t* result) const {
+    decodeVector(_linearAcceleration, result);
+}
+
+bool IMU::requestVectors() {
+    bool result = queueRead(REGISTER_EULER, 1, _euler, 6);
+    return queueRead(REGISTER_LINEAR_ACCEL, 1, _linearAcceleration, 6) && result;
+}
+
+void IMU::decodeVector(const uint8_t* data, int16_t* result) const {
+    for (uint8_t i = 0; i < 3; ++i) {
+        // little endian
+        uint16_t value = data[2 * i];
+        value |= static_cast<uint16_t>(data[2 * i + 1]) << 8;
+        result[i] = static_cast<int16_t>(value);
+    }
+}
@@ -0,0 +1,60 @@
+/*
+ * Copyright (C) 2026 by Stefan Rothe
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef IMU_H
+#define IMU_H
+
+#include "i2cdevice.h"
+
+/******************************************************************************
+ * class IMU
+ *
+ * Reads the fusion results of the BNO055 as raw register values. The chip is
+ * set up by the Adafruit library.
+ *****************************************************************************/
+
+class IMU : public I2CDevice {
+public:
+    // register units: 1 m/s^2 = 100 LSB, 1 degree = 16 LSB
+    static const int16_t ACCEL_LSB;
+    static const int16_t EULER_LSB;
+
+    IMU(uint8_t address);
+
+    /**
+     * Returns heading, roll and pitch in this order, as read by the last
+     * completed requestVectors().
+     */
+    void euler(int16_t* result) const;
+
+    /**
+     * Returns the linear acceleration along the x, y and z axes in this
+     * order, as read by the last completed requestVectors().
+     */
+    void linearAcceleration(int16_t* result) const;
+
+    /**
+     * Queues a read of the euler angles and the linear acceleration.
+     */
+    bool requestVectors();
+private:
+    void decodeVector(const uint8_t* data, int16_t* result) const;
+    uint8_t _euler[6];
+    uint8_t _linearAcceleration[6];
+};
+
+#endif
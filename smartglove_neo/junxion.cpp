@@ -34,6 +34,7 @@
 #define JUNXION_ID_RESPONSE 'j'
 #define INPUT_CONFIG_REQUEST 'I'
 #define INPUT_CONFIG_RESPONSE 'p'
+#define NEOPIXEL_FRAME 'L'
 #define JUNXION_ID 308
 
 #define JUNXION_BAUD_RATE 115200
@@ -47,7 +48,7 @@
  * analog and own pin mapping
  *****************************************************************************/
 
-const uint8_t ANALOG_PIN_COUNT = 4;
+const uint8_t ANALOG_PIN_COUNT = JUNXION_ANALOG_PIN_COUNT;
 
 const uint8_t ANALOG_PIN_MAP[ANALOG_PIN_COUNT] = {
     SENSOR_FLEX_INDEX_FINGER,
@@ -56,7 +57,7 @@ const uint8_t ANALOG_PIN_MAP[ANALOG_PIN_COUNT] = {
     SENSOR_FLEX_LITTLE_FINGER
 };
 
-const uint8_t OWN_PIN_COUNT = 8;
+const uint8_t OWN_PIN_COUNT = JUNXION_OWN_PIN_COUNT;
 
 #define JUNXION_STATE 255
 
@@ -75,7 +76,7 @@ const uint8_t OWN_PIN_MAP[OWN_PIN_COUNT] = {
  * digital pin mapping
  *****************************************************************************/
 
-const uint8_t DIGITAL_PIN_COUNT = 16;
+const uint8_t DIGITAL_PIN_COUNT = JUNXION_DIGITAL_PIN_COUNT;
 const bool DIGITAL_PIN_BUTTON[DIGITAL_PIN_COUNT] = {
     true, true, true, true, true, true, true, true,
     false, false, false, false, true, true, true, true
@@ -106,9 +107,13 @@ const uint8_t DIGITAL_PIN_MAP[DIGITAL_PIN_COUNT] = {
 
 Junxion::Junxion(SmartDevice& device) :
     Behaviour(device),
+    _analogPinCount(0),
     _boardId(1),
     _dataSize(0),
+    _digitalButtonMask(0),
+    _digitalPinCount(0),
     _headerReceived(false),
+    _ownPinCount(0),
     _sendData(false),
     _serialAvailable(false),
     _serialCheckMs(0),
@@ -117,11 +122,17 @@ Junxion::Junxion(SmartDevice& device) :
 }
 
 void Junxion::setup() {
-    _dataSize = 2 * (analogPinCount() + ownPinCount() + (digitalPinCount() / 16) + 1);
+    setupPins();
     _boardId = Storage.boardId();
 }
 
 void Junxion::loop() {
+    if (Storage.protocol() != PROTOCOL_JUNXION) {
+        // another preset has been selected, InitBehaviour starts its protocol
+        device.popBehaviour();
+        return;
+    }
+
     if (device.commandMenu()) {
         device.popBehaviour();
         device.pushBehaviour(new MainMenu(device));
@@ -138,6 +149,7 @@ void Junxion::loop() {
         _serialAvailable = static_cast<bool>(Serial);
         if (!_serialAvailable) {
             Serial.begin(JUNXION_BAUD_RATE);
+            device.serialQueue().clear();
             sendJunxionId();
             sendInputConfig();
         }
@@ -146,10 +158,13 @@ void Junxion::loop() {
     }
 
     if (!_serialAvailable) {
-        device.display().setTextAlign(ALIGN_LEFT);
-        device.display().setFont(&HELVETICA_10);
-        device.display().drawText(10, 8, "Waiting for");
-        device.display().drawText(10, 22, "serial connection...");
+        if (device.renderFrame()) {
+            device.display().setTextAlign(ALIGN_LEFT);
+            device.display().setFont(&FONT_SMALL);
+            device.display().drawText(10, 8, "Waiting for");
+            device.display().drawText(10, 22, "serial connection...");
+        }
+
         return;
     }
 
@@ -163,7 +178,17 @@ void Junxion::loop() {
     }
 
     if (_headerReceived && Serial.available() > _packageSize) {
-        handleCommand(Serial.read());
+        char cmd = Serial.read();
+        uint8_t length = 0;
+        for (unsigned int i = 0; i < _packageSize; ++i) {
+            int data = Serial.read();
+            if (length < JUNXION_PAYLOAD_CAPACITY) {
+                _payload[length] = data;
+                ++length;
+            }
+        }
+
+        handleCommand(cmd, _payload, length);
         _headerReceived = false;
     }
 
@@ -189,59 +214,16 @@ void Junxion::loop() {
         }
     }
 
-    char text[10];
-    sprintf(text, "%i", _state);
-    device.display().setFont(&SWISS_20_B);
-    device.display().setTextAlign(ALIGN_CENTER);
-    device.display().drawText(64, 12, text);
-}
-
-bool Junxion::analogPinAvailable(uint8_t pin) const {
-    if (pin >= ANALOG_PIN_COUNT) {
-        return false;
-    }
-
-    return device.sensorAvailable(ANALOG_PIN_MAP[pin]);
-}
-
-uint8_t Junxion::analogPinCount() const {
-    uint8_t result = 0;
-    for (uint8_t id = 0; id < ANALOG_PIN_COUNT; ++id) {
-        if (analogPinAvailable(id)) {
-            ++result;
-        }
-    }
-
-    return result;
-}
-
-uint16_t Junxion::analogPinValue(uint8_t pin) const {
-    if (pin >= ANALOG_PIN_COUNT) {
-        return 0;
-    }
-
-    return device.sensorValue(ANALOG_PIN_MAP[pin]);
-}
-
-bool Junxion::digitalPinActive(uint8_t pin) const {
-    if (pin >= DIGITAL_PIN_COUNT) {
-        return false;
-    }
-
-    uint8_t id = DIGITAL_PIN_MAP[pin];
-    if (DIGITAL_PIN_BUTTON[pin]) {
-        return device.buttonAvailable(id) && device.buttonPressed(id);
-    }
-    else {
-        return device.gestureAvailable(id) && device.gestureDetected(id);
+    if (device.renderFrame()) {
+        char text[10];
+        sprintf(text, "%i", _state);
+        device.display().setFont(&FONT_HUGE);
+        device.display().setTextAlign(ALIGN_CENTER);
+        device.display().drawText(64, 12, text);
     }
 }
 
 bool Junxion::digitalPinAvailable(uint8_t pin) const {
-    if (pin >= DIGITAL_PIN_COUNT) {
-        return false;
-    }
-
     uint8_t id = DIGITAL_PIN_MAP[pin];
     if (DIGITAL_PIN_BUTTON[pin]) {
         return device.buttonAvailable(id);
@@ -251,52 +233,7 @@ bool Junxion::digitalPinAvailable(uint8_t pin) const {
     }
 }
 
-uint8_t Junxion::digitalPinCount() const {
-    uint8_t result = 0;
-    for (uint8_t id = 0; id < DIGITAL_PIN_COUNT; ++id) {
-        if (digitalPinAvailable(id)) {
-            ++result;
-        }
-    }
-
-    return result;
-}
-
-bool Junxion::ownPinAvailable(uint8_t pin) const {
-    if (pin >= OWN_PIN_COUNT) {
-        return false;
-    }
-
-    if (OWN_PIN_MAP[pin] == JUNXION_STATE) {
-        return true;
-    }
-
-    return device.sensorAvailable(OWN_PIN_MAP[pin]);
-}
-
-uint8_t Junxion::ownPinCount() const {
-    uint8_t result = 0;
-    for (uint8_t id = 0; id < OWN_PIN_COUNT; ++id) {
-        if (ownPinAvailable(id)) {
-            ++result;
-        }
-    }
-    return result;
-}
-
-uint16_t Junxion::ownPinValue(uint8_t pin) const {
-    if (pin >= OWN_PIN_COUNT) {
-        return 0;
-    }
-
-    if (OWN_PIN_MAP[pin] == JUNXION_STATE) {
-        return _state * 65536 / 127;
-    }
-
-    return device.sensorValue(OWN_PIN_MAP[pin]);
-}
-
-void Junxion::handleCommand(char cmd) {
+void Junxion::handleCommand(char cmd, const uint8_t* payload, uint8_t length) {
     switch (cmd) {
         case START_DATA:
             _sendData = true;
@@ -305,8 +242,9 @@ void Junxion::handleCommand(char cmd) {
             _sendData = false;
             break;
         case BOARD_ID_REQUEST:
-            sendHeader(BOARD_ID_RESPONSE, 1);
-            Serial.write(_boardId);
+            if (sendHeader(BOARD_ID_RESPONSE, 1)) {
+                device.serialQueue().write(_boardId);
+            }
             break;
         case JUNXION_ID_REQUEST:
             sendJunxionId();
@@ -314,26 +252,40 @@ void Junxion::handleCommand(char cmd) {
         case INPUT_CONFIG_REQUEST:
             sendInputConfig();
             break;
+        case NEOPIXEL_FRAME:
+            device.setNeoPixelFrame(payload, length);
+            break;
     }
 }
 
 void Junxion::sendData() const {
-    sendHeader(DATA_RESPONSE, _dataSize);
+    if (!sendHeader(DATA_RESPONSE, _dataSize)) {
+        // previous frames are still being transmitted, skip this one
+        return;
+    }
+
     // Send digital input states
     uint16_t state = 0;
     uint8_t pos = 0;
-    for (uint8_t i = 0; i < DIGITAL_PIN_COUNT; ++i) {
-        if (digitalPinAvailable(i)) {
-            if (digitalPinActive(i)) {
-                state = state | (1 << pos);
-            }
+    for (uint8_t i = 0; i < _digitalPinCount; ++i) {
+        uint8_t id = _digitalIds[i];
+        bool active;
+        if (_digitalButtonMask & (1 << i)) {
+            active = device.buttonPressed(id);
+        }
+        else {
+            active = device.gestureDetected(id);
+        }
 
-            ++pos;
-            if (pos >= 16) {
-                sendUInt16(state);
-                state = 0;
-                pos = 0;
-            }
+        if (active) {
+            state = state | (1 << pos);
+        }
+
+        ++pos;
+        if (pos >= 16) {
+            sendUInt16(state);
+            state = 0;
+            pos = 0;
         }
     }
 
@@ -342,59 +294,100 @@ void Junxion::sendData() const {
     }
 
     // Send analog pin states
-    for (uint8_t i = 0; i < ANALOG_PIN_COUNT; ++i) {
-        if (analogPinAvailable(i)) {
-            sendUInt16(analogPinValue(i));
-        }
+    for (uint8_t i = 0; i < _analogPinCount; ++i) {
+        sendUInt16(device.sensorValue(ANALOG_PIN_MAP[_analogPins[i]]));
     }
 
-    for (uint8_t i = 0; i < OWN_PIN_COUNT; ++i) {
-        if (ownPinAvailable(i)) {
-            sendUInt16(ownPinValue(i));
+    for (uint8_t i = 0; i < _ownPinCount; ++i) {
+        uint8_t id = OWN_PIN_MAP[_ownPins[i]];
+        if (id == JUNXION_STATE) {
+            sendUInt16(_state * 65536 / 127);
+        }
+        else {
+            sendUInt16(device.sensorValue(id));
         }
     }
 }
 
-void Junxion::sendHeader(char cmd, uint8_t dataSize) const {
-    Serial.write(HEADER);
-    Serial.write(HEADER);
-    Serial.write(dataSize);
-    Serial.print(cmd);
+bool Junxion::sendHeader(char cmd, uint8_t dataSize) const {
+    SerialQueue& queue = device.serialQueue();
+    if (!queue.beginFrame(4 + dataSize)) {
+        return false;
+    }
+
+    queue.write(HEADER);
+    queue.write(HEADER);
+    queue.write(dataSize);
+    queue.write(cmd);
+    return true;
 }
 
 void Junxion::sendInputConfig() const {
-    sendHeader(INPUT_CONFIG_RESPONSE, 3 * (analogPinCount() + ownPinCount() + digitalPinCount()));
-    for (uint8_t i = 0; i < DIGITAL_PIN_COUNT; ++i) {
-        if (digitalPinAvailable(i)) {
-            Serial.write(DIGITAL);
-            Serial.write(i);
-            Serial.write(DIGITAL_RESOLUTION);
-        }
+    if (!sendHeader(INPUT_CONFIG_RESPONSE, 3 * (_analogPinCount + _ownPinCount + _digitalPinCount))) {
+        return;
     }
 
-    for (uint8_t i = 0; i < ANALOG_PIN_COUNT; ++i) {
-        if (analogPinAvailable(i)) {
-            Serial.write('a');
-            Serial.write(i);
-            Serial.write(16);
-        }
+    SerialQueue& queue = device.serialQueue();
+    for (uint8_t i = 0; i < _digitalPinCount; ++i) {
+        queue.write(DIGITAL);
+        queue.write(_digitalPins[i]);
+        queue.write(DIGITAL_RESOLUTION);
     }
 
-    for (uint8_t i = 0; i < OWN_PIN_COUNT; ++i) {
-        if (ownPinAvailable(i)) {
-            Serial.write('o');
-            Serial.write(i);
-            Serial.write(16);
-        }
+    for (uint8_t i = 0; i < _analogPinCount; ++i) {
+        queue.write('a');
+        queue.write(_analogPins[i]);
+        queue.write(16);
+    }
+
+    for (uint8_t i = 0; i < _ownPinCount; ++i) {
+        queue.write('o');
+        queue.write(_ownPins[i]);
+        queue.write(16);
     }
 }
 
 void Junxion::sendJunxionId() const {
-    sendHeader(JUNXION_ID_RESPONSE, 2);
-    sendUInt16(JUNXION_ID);
+    if (sendHeader(JUNXION_ID_RESPONSE, 2)) {
+        sendUInt16(JUNXION_ID);
+    }
 }
 
 void Junxion::sendUInt16(uint16_t data) const {
-    Serial.write(data / 256);
-    Serial.write(data % 256);
+    device.serialQueue().write16(data);
+}
+
+void Junxion::setupPins() {
+    _digitalButtonMask = 0;
+    _digitalPinCount = 0;
+    for (uint8_t pin = 0; pin < DIGITAL_PIN_COUNT; ++pin) {
+        if (digitalPinAvailable(pin)) {
+            if (DIGITAL_PIN_BUTTON[pin]) {
+                _digitalButtonMask |= 1 << _digitalPinCount;
+            }
+
+            _digitalIds[_digitalPinCount] = DIGITAL_PIN_MAP[pin];
+            _digitalPins[_digitalPinCount] = pin;
+            ++_digitalPinCount;
+        }
+    }
+
+    _analogPinCount = 0;
+    for (uint8_t pin = 0; pin < ANALOG_PIN_COUNT; ++pin) {
+        if (device.sensorAvailable(ANALOG_PIN_MAP[pin])) {
+            _analogPins[_analogPinCount] = pin;
+            ++_analogPinCount;
+        }
+    }
+
+    _ownPinCount = 0;
+    for (uint8_t pin = 0; pin < OWN_PIN_COUNT; ++pin) {
+        if (OWN_PIN_MAP[pin] == JUNXION_STATE || device.sensorAvailable(OWN_PIN_MAP[pin])) {
+            _ownPins[_ownPinCount] = pin;
+            ++_ownPinCount;
+        }
+    }
+
+    // digital states are sent as 16 bit words
+    _dataSize = 2 * ((_digitalPinCount + 15) / 16 + _analogPinCount + _ownPinCount);
 }
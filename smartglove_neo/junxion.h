@@ -21,6 +21,12 @@
 #include <Arduino.h>
 #include "smart_device.h"
 
+#define JUNXION_ANALOG_PIN_COUNT 4
+#define JUNXION_DIGITAL_PIN_COUNT 16
+#define JUNXION_OWN_PIN_COUNT 8
+// largest command payload that is kept, longer payloads are truncated
+#define JUNXION_PAYLOAD_CAPACITY 162
+
 // ----------------------------------------------------------------------------
 // class Junxion
 // ----------------------------------------------------------------------------
@@ -34,25 +40,28 @@ private:
     Junxion(const Junxion&);
     Junxion& operator=(const Junxion&);
 
-    bool analogPinAvailable(uint8_t pin) const;
-    uint8_t analogPinCount() const;
-    uint16_t analogPinValue(uint8_t pin) const;
-    bool digitalPinActive(uint8_t pin) const;
     bool digitalPinAvailable(uint8_t pin) const;
-    uint8_t digitalPinCount() const;
-    bool ownPinAvailable(uint8_t pin) const;
-    uint8_t ownPinCount() const;
-    uint16_t ownPinValue(uint8_t pin) const;
-    void handleCommand(char cmd);
+    void handleCommand(char cmd, const uint8_t* payload, uint8_t length);
     void sendData() const;
-    void sendHeader(char cmd, uint8_t dataSize) const;
+    bool sendHeader(char cmd, uint8_t dataSize) const;
     void sendInputConfig() const;
     void sendJunxionId() const;
     void sendUInt16(uint16_t data) const;
+    void setupPins();
+    // available pins, resolved once in setup()
+    uint8_t _analogPins[JUNXION_ANALOG_PIN_COUNT];
+    uint8_t _analogPinCount;
     uint8_t _boardId;
     uint8_t _dataSize;
+    uint16_t _digitalButtonMask;
+    uint8_t _digitalIds[JUNXION_DIGITAL_PIN_COUNT];
+    uint8_t _digitalPins[JUNXION_DIGITAL_PIN_COUNT];
+    uint8_t _digitalPinCount;
     bool _headerReceived;
+    uint8_t _ownPins[JUNXION_OWN_PIN_COUNT];
+    uint8_t _ownPinCount;
     unsigned int  _packageSize;
+    uint8_t _payload[JUNXION_PAYLOAD_CAPACITY];
     bool _sendData;
     bool _serialAvailable;
     unsigned long _serialCheckMs;
@@ -18,6 +18,7 @@
 #include "max.h"
 #include "config.h"
 #include "behaviour.h"
+#include "storage.h"
 
 #define FIRMATA_BAUD_RATE 57600
 
@@ -26,10 +27,24 @@
 
 #define REPORT_FIRMWARE 0x79
 
-#define RECEIVED_NOTHING       0
-#define RECEIVED_HEADER        1
-#define RECEIVED_TYPE_STATE    2
-#define RECEIVED_TYPE_NEOPIXEL 3
+#define RECEIVE_START   0
+#define RECEIVE_TYPE    1
+#define RECEIVE_LENGTH  2
+#define RECEIVE_PAYLOAD 3
+#define RECEIVE_END     4
+
+#define MESSAGE_START 'S'
+#define MESSAGE_END   'E'
+// start, type, length and end byte
+#define MESSAGE_OVERHEAD 4
+
+#define MESSAGE_DEADBAND 'B'
+#define MESSAGE_FRAME    'F'
+#define MESSAGE_NEOPIXEL 'N'
+#define MESSAGE_OUTPUT   'O'
+#define MESSAGE_STATE    'S'
+
+#define OUTPUT_ALL_PINS 255
 
 const uint8_t DIGITAL_PIN_COUNT = 16;
 const bool DIGITAL_PIN_BUTTON[DIGITAL_PIN_COUNT] = {
@@ -57,7 +72,7 @@ const uint8_t DIGITAL_PIN_MAP[DIGITAL_PIN_COUNT] = {
 };
 
 
-const uint8_t ANALOG_PIN_COUNT = 11;
+const uint8_t ANALOG_PIN_COUNT = MAX_ANALOG_PIN_COUNT;
 const uint8_t ANALOG_PIN_MAP[ANALOG_PIN_COUNT] = {
     SENSOR_DISTANCE,
     SENSOR_ACCEL_X,
@@ -74,19 +89,40 @@ const uint8_t ANALOG_PIN_MAP[ANALOG_PIN_COUNT] = {
 
 Max::Max(SmartDevice& device) :
     Behaviour(device),
-    _receiveState(RECEIVED_NOTHING),
+    _analogSentMs(0),
+    _digitalSentMs(0),
+    _keepAliveMs(MAX_KEEP_ALIVE_MS),
+    _lastDigital(0),
+    _outputIntervalMs(MAX_OUTPUT_INTERVAL_MS),
+    _outputOnChange(MAX_OUTPUT_ON_CHANGE),
+    _commandCount(0),
+    _commandHead(0),
+    _messageLength(0),
+    _messageType(0),
+    _payloadLength(0),
+    _receiveState(RECEIVE_START),
     _serialConnected(false),
     _serialCheckMs(0),
     _state(0)
 {
+    for (uint8_t i = 0; i < ANALOG_PIN_COUNT; ++i) {
+        _deadband[i] = MAX_DEADBAND;
+        _lastAnalog[i] = 0;
+    }
 }
 
 void Max::setup() {
     device.display().setTextAlign(ALIGN_LEFT);
-    device.display().setFont(&HELVETICA_10);
+    device.display().setFont(&FONT_SMALL);
 }
 
 void Max::loop() {
+    if (Storage.protocol() != PROTOCOL_MAX) {
+        // another preset has been selected, InitBehaviour starts its protocol
+        device.popBehaviour();
+        return;
+    }
+
     if (device.commandMenu()) {
         device.popBehaviour();
         device.pushBehaviour(new MainMenu(device));
@@ -110,103 +146,186 @@ void Max::loop() {
     }
 
     if (!_serialConnected) {
-        device.display().setTextAlign(ALIGN_LEFT);
-        device.display().setFont(&HELVETICA_10);
-        device.display().drawText(10, 8, "Waiting for");
-        device.display().drawText(10, 22, "Max connection...");
+        if (device.renderFrame()) {
+            device.display().setTextAlign(ALIGN_LEFT);
+            device.display().setFont(&FONT_SMALL);
+            device.display().drawText(10, 8, "Waiting for");
+            device.display().drawText(10, 22, "Max connection...");
+        }
+
         return;
     }
 
-    char text[10];
-    sprintf(text, "%i", _state);
-    device.display().setFont(&SWISS_20_B);
-    device.display().setTextAlign(ALIGN_CENTER);
-    device.display().drawText(64, 12, text);
+    if (device.renderFrame()) {
+        char text[10];
+        sprintf(text, "%i", _state);
+        device.display().setFont(&FONT_HUGE);
+        device.display().setTextAlign(ALIGN_CENTER);
+        device.display().drawText(64, 12, text);
+    }
+
     receive();
-    sendDigital();
-    sendAnalog();
+    updateDigital(now);
+    updateAnalog(now);
 }
 
-void Max::receive() {
-    switch (_receiveState) {
-    case RECEIVED_NOTHING:
-        if (Serial.available() && Serial.read() == 'S') {
-            _receiveState = RECEIVED_HEADER;
-        }
-        break;
-    case RECEIVED_HEADER:
-        if (Serial.available()) {
-            switch (Serial.read()) {
-                case 'S':
-                    _receiveState = RECEIVED_TYPE_STATE;
-                    break;
-                case 'N':
-                    _receiveState = RECEIVED_TYPE_NEOPIXEL;
-                    break;
-                default:
-                    _receiveState = RECEIVED_NOTHING;
-                    break;
+void Max::applyCommand(const MaxCommand& command) {
+    const uint8_t* data = command.data;
+    switch (command.type) {
+    case MESSAGE_DEADBAND:
+        for (uint8_t i = 0; i < ANALOG_PIN_COUNT; ++i) {
+            if (data[0] == i || data[0] == OUTPUT_ALL_PINS) {
+                _deadband[i] = (data[1] << 8) | data[2];
             }
         }
         break;
-    case RECEIVED_TYPE_NEOPIXEL:
-        if (Serial.available() >= 7) {
-            receiveNeopixel();
-            _receiveState = RECEIVED_NOTHING;
-        }
+    case MESSAGE_NEOPIXEL:
+        device.setNeoPixel(data[0], data[1], data[2], data[3], data[4]);
         break;
-    case RECEIVED_TYPE_STATE:
-        if (Serial.available() >= 3) {
-            receiveState();
-            _receiveState = RECEIVED_NOTHING;
-        }
+    case MESSAGE_OUTPUT:
+        _outputIntervalMs = data[0];
+        _outputOnChange = data[1] != 0;
+        _keepAliveMs = (data[2] << 8) | data[3];
+        break;
+    case MESSAGE_STATE:
+        _state = data[0];
         break;
     }
 }
 
-void Max::receiveNeopixel() {
-    Serial.read(); // length
-    uint8_t fingerIndex = Serial.read();
-    uint8_t pixelIndex = Serial.read();
-    uint8_t red = Serial.read();
-    uint8_t green = Serial.read();
-    uint8_t blue = Serial.read();
-    device.setNeoPixel(fingerIndex, pixelIndex, red, green, blue);
-    Serial.read(); // 'E'
+void Max::applyCommands() {
+    while (_commandCount > 0) {
+        applyCommand(_commands[_commandHead]);
+        _commandHead = (_commandHead + 1) % MAX_COMMAND_QUEUE_SIZE;
+        --_commandCount;
+    }
+}
+
+bool Max::validLength(uint8_t type, uint8_t length) {
+    switch (type) {
+    case MESSAGE_DEADBAND:
+        return length == 7;
+    case MESSAGE_FRAME:
+        // at least one pixel
+        return length >= MESSAGE_OVERHEAD + 5 && length <= MESSAGE_OVERHEAD + MAX_FRAME_SIZE;
+    case MESSAGE_NEOPIXEL:
+        // with or without the trailing value byte
+        return length == 9 || length == 10;
+    case MESSAGE_OUTPUT:
+        return length == 8;
+    case MESSAGE_STATE:
+        return length == 5;
+    default:
+        return false;
+    }
+}
+
+void Max::receive() {
+    // decode everything that has arrived, unless the command queue is full
+    while (_commandCount < MAX_COMMAND_QUEUE_SIZE && Serial.available() > 0) {
+        uint8_t data = Serial.read();
+        switch (_receiveState) {
+        case RECEIVE_START:
+            if (data == MESSAGE_START) {
+                _receiveState = RECEIVE_TYPE;
+            }
+            break;
+        case RECEIVE_TYPE:
+            _messageType = data;
+            _receiveState = RECEIVE_LENGTH;
+            break;
+        case RECEIVE_LENGTH:
+            if (!validLength(_messageType, data)) {
+                if (_messageType == MESSAGE_START) {
+                    // the start byte was a stray one, data is the type
+                    _messageType = data;
+                }
+                else {
+                    resync(data);
+                }
+
+                break;
+            }
+
+            _messageLength = data;
+            _payloadLength = 0;
+            _receiveState = RECEIVE_PAYLOAD;
+            break;
+        case RECEIVE_PAYLOAD:
+            if (_messageType == MESSAGE_FRAME) {
+                _frame[_payloadLength] = data;
+            }
+            else if (_payloadLength < MAX_COMMAND_SIZE) {
+                _commands[(_commandHead + _commandCount) % MAX_COMMAND_QUEUE_SIZE].data[_payloadLength] = data;
+            }
+
+            ++_payloadLength;
+            if (_payloadLength == _messageLength - MESSAGE_OVERHEAD) {
+                _receiveState = RECEIVE_END;
+            }
+            break;
+        case RECEIVE_END:
+            if (data == MESSAGE_END && _messageType == MESSAGE_FRAME) {
+                // frames are not queued, keep the order of earlier commands
+                applyCommands();
+                device.setNeoPixelFrame(_frame, _payloadLength);
+                _receiveState = RECEIVE_START;
+            }
+            else if (data == MESSAGE_END) {
+                _commands[(_commandHead + _commandCount) % MAX_COMMAND_QUEUE_SIZE].type = _messageType;
+                ++_commandCount;
+                _receiveState = RECEIVE_START;
+            }
+            else {
+                resync(data);
+            }
+            break;
+        }
+    }
+
+    applyCommands();
 }
 
-void Max::receiveState() {
-    Serial.read(); // length
-    _state = Serial.read();
-    Serial.read(); // 'E'
+void Max::resync(uint8_t data) {
+    // the message is corrupt, the byte that broke it may start the next one
+    _receiveState = data == MESSAGE_START ? RECEIVE_TYPE : RECEIVE_START;
 }
 
-void Max::sendAnalog() {
+bool Max::sendAnalog(const uint16_t* values) {
+    if (!device.serialQueue().beginFrame(4 + 2 * ANALOG_PIN_COUNT)) {
+        return false;
+    }
+
     sendByte('S');
     sendByte('A');
     sendByte(4 + 2 * ANALOG_PIN_COUNT);
     for (uint8_t i = 0; i < ANALOG_PIN_COUNT; ++i) {
-        sendSensor(ANALOG_PIN_MAP[i]);
+        device.serialQueue().write16(values[i]);
     }
     sendByte('E');
+    return true;
 }
 
-void Max::sendDigital() {
+bool Max::sendDigital(uint16_t state) {
+    if (!device.serialQueue().beginFrame(4 + DIGITAL_PIN_COUNT)) {
+        return false;
+    }
+
     sendByte('S');
     sendByte('D');
     sendByte(4 + DIGITAL_PIN_COUNT);
     for (uint8_t i = 0; i < DIGITAL_PIN_COUNT; ++i) {
-        if (DIGITAL_PIN_BUTTON[i]) {
-            sendButton(DIGITAL_PIN_MAP[i]);
-        }
-        else {
-            sendGesture(DIGITAL_PIN_MAP[i]);
-        }
+        sendByte((state >> i) & 1);
     }
     sendByte('E');
+    return true;
 }
 
 void Max::sendInformation() {
+    if (!device.serialQueue().beginFrame(10)) {
+        return;
+    }
+
     sendByte('S');
     sendByte('I');
     sendByte(10);
@@ -219,20 +338,69 @@ void Max::sendInformation() {
     sendByte('E');
 }
 
-void Max::sendSensor(uint8_t id) {
-    uint16_t value = device.sensorValue(id);
-    Serial.write(value >> 8);
-    Serial.write(value & 0xFF);
+void Max::sendByte(uint8_t data) {
+    device.serialQueue().write(data);
 }
 
-void Max::sendButton(uint8_t button) {
-    Serial.write(device.buttonPressed(button) ? 1 : 0);
-}
+void Max::updateAnalog(unsigned long now) {
+    if (now - _analogSentMs < _outputIntervalMs) {
+        return;
+    }
 
-void Max::sendGesture(uint8_t gesture) {
-    Serial.write(device.gestureDetected(gesture) ? 1 : 0);
+    uint16_t values[ANALOG_PIN_COUNT];
+    bool changed = false;
+    for (uint8_t i = 0; i < ANALOG_PIN_COUNT; ++i) {
+        values[i] = device.sensorValue(ANALOG_PIN_MAP[i]);
+        // compared to the last value sent, so that slow drifts are reported
+        uint16_t delta = values[i] > _lastAnalog[i] ? values[i] - _lastAnalog[i] : _lastAnalog[i] - values[i];
+        if (delta > _deadband[i]) {
+            changed = true;
+        }
+    }
+
+    if (_outputOnChange && !changed && (_keepAliveMs == 0 || now - _analogSentMs < _keepAliveMs)) {
+        return;
+    }
+
+    if (!sendAnalog(values)) {
+        return;
+    }
+
+    for (uint8_t i = 0; i < ANALOG_PIN_COUNT; ++i) {
+        _lastAnalog[i] = values[i];
+    }
+
+    _analogSentMs = now;
 }
 
-void Max::sendByte(uint8_t data) {
-    Serial.write(data);
+void Max::updateDigital(unsigned long now) {
+    if (now - _digitalSentMs < _outputIntervalMs) {
+        return;
+    }
+
+    uint16_t state = 0;
+    for (uint8_t i = 0; i < DIGITAL_PIN_COUNT; ++i) {
+        bool active;
+        if (DIGITAL_PIN_BUTTON[i]) {
+            active = device.buttonPressed(DIGITAL_PIN_MAP[i]);
+        }
+        else {
+            active = device.gestureDetected(DIGITAL_PIN_MAP[i]);
+        }
+
+        if (active) {
+            state |= 1 << i;
+        }
+    }
+
+    if (_outputOnChange && state == _lastDigital && (_keepAliveMs == 0 || now - _digitalSentMs < _keepAliveMs)) {
+        return;
+    }
+
+    if (!sendDigital(state)) {
+        return;
+    }
+
+    _lastDigital = state;
+    _digitalSentMs = now;
 }
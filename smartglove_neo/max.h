@@ -21,6 +21,17 @@
 #include <Arduino.h>
 #include "smart_device.h"
 
+#define MAX_ANALOG_PIN_COUNT 11
+#define MAX_COMMAND_QUEUE_SIZE 48
+#define MAX_COMMAND_SIZE 6
+// finger, encoding and up to 40 run-length encoded pixels
+#define MAX_FRAME_SIZE 162
+
+struct MaxCommand {
+    uint8_t type;
+    uint8_t data[MAX_COMMAND_SIZE];
+};
+
 // ----------------------------------------------------------------------------
 // class Maxx
 // ----------------------------------------------------------------------------
@@ -34,18 +45,32 @@ public:
 private:
     Max(const Max&);
     Max& operator=(const Max&);
+    void applyCommand(const MaxCommand& command);
+    void applyCommands();
     void receive();
-    void receiveNeopixel();
-    void receiveState();
-    void sendAnalog();
-    void sendDigital();
+    void resync(uint8_t data);
+    bool sendAnalog(const uint16_t* values);
+    bool sendDigital(uint16_t state);
     void sendInformation();
-    void sendButton(uint8_t button);
-    void sendGesture(uint8_t gesture);
-    void sendSensor(uint8_t id);
     void sendByte(uint8_t data);
+    void updateAnalog(unsigned long now);
+    void updateDigital(unsigned long now);
+    static bool validLength(uint8_t type, uint8_t length);
+    unsigned long _analogSentMs;
+    uint8_t _commandCount;
+    uint8_t _commandHead;
+    MaxCommand _commands[MAX_COMMAND_QUEUE_SIZE];
+    uint16_t _deadband[MAX_ANALOG_PIN_COUNT];
+    unsigned long _digitalSentMs;
+    uint8_t _frame[MAX_FRAME_SIZE];
+    uint16_t _keepAliveMs;
+    uint16_t _lastAnalog[MAX_ANALOG_PIN_COUNT];
+    uint16_t _lastDigital;
     uint8_t _messageLength;
     uint8_t _messageType;
+    bool _outputOnChange;
+    uint8_t _outputIntervalMs;
+    uint8_t _payloadLength;
     uint8_t _receiveState;
     uint8_t _state;
     bool _serialConnected;
@@ -23,15 +23,18 @@
 #define REGISTER_CONFIG   0x03
 
 PCA9557::PCA9557(uint8_t address) :
-    I2CDevice(address) {
+    I2CDevice(address, I2C_PRIORITY_HIGH),
+    _input(0),
+    _output(0) {
 }
 
-uint8_t PCA9557::readInput() const {
-    beginTransmission();
-    write(REGISTER_INPUT);
-    endTransmission();
-    requestData(1);
-    return read();
+bool PCA9557::queueOutput(uint8_t data) {
+    _output = data;
+    return queueWrite(REGISTER_OUTPUT, 1, &_output, 1);
+}
+
+bool PCA9557::requestInput() {
+    return queueRead(REGISTER_INPUT, 1, &_input, 1);
 }
 
 void PCA9557::writeConfig(uint8_t config) const {
@@ -41,13 +44,6 @@ void PCA9557::writeConfig(uint8_t config) const {
     endTransmission();
 }
 
-void PCA9557::writeOutput(uint8_t data) const {
-    beginTransmission();
-    write(REGISTER_OUTPUT);
-    write(data);
-    endTransmission();
-}
-
 void PCA9557::writePolarity(uint8_t polarity) const {
     beginTransmission();
     write(REGISTER_POLARITY);
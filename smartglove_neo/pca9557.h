@@ -25,9 +25,22 @@ public:
     PCA9557(uint8_t address);
 
     /**
-     * Reads a byte from the input register.
+     * Returns the input register as read by the last completed
+     * requestInput().
      */
-    uint8_t readInput() const;
+    inline uint8_t input() const { return _input; }
+
+    /**
+     * Queues a write to the output register. Depending on the polarity
+     * register a set bit either sets the output to VCC or to GND. If several
+     * writes are queued, all of them write the latest value.
+     */
+    bool queueOutput(uint8_t data);
+
+    /**
+     * Queues a read of the input register.
+     */
+    bool requestInput();
 
     /**
      * Writes to the config register. The config register defines the input/output
@@ -36,18 +49,15 @@ public:
      */
     void writeConfig(uint8_t config) const;
 
-    /**
-     * Writes a byte to the output register. Depending on the polarity register
-     * a set bit either sets the output to VCC or to GND.
-     */
-    void writeOutput(uint8_t data) const;
-
     /**
      * Writes to the polarity register. The polarity register defines the polarity
      * of the output. If the corresponding polarity bit is set, the polarity
      * is inverted, i.e. the set bit sets the output to GND instead of VCC.
      */
     void writePolarity(uint8_t polarity) const;
+private:
+    uint8_t _input;
+    uint8_t _output;
 };
 
 #endif
@@ -0,0 +1,151 @@
+/*
+ * Copyright (C) 2026 by Stefan Rothe
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "profiler.h"
+
+/******************************************************************************
+ * class LoopProfiler
+ *****************************************************************************/
+
+const uint8_t LoopProfiler::PHASE_COUNT = PHASE_LOOP + 1;
+const uint8_t LoopProfiler::BUCKET_COUNT = 16;
+
+static const char* PHASE_NAMES[PHASE_LOOP + 1] = {
+    "Buttons",
+    "IMU",
+    "Flex/Distance",
+    "Behaviour",
+    "Serial",
+    "Display",
+    "I2C",
+    "Loop"
+};
+
+LoopProfiler::LoopProfiler() :
+    _buckets(new uint16_t[PHASE_COUNT * BUCKET_COUNT]),
+    _lapMicros(0),
+    _startMicros(0) {
+    reset();
+}
+
+uint32_t LoopProfiler::average(uint8_t phase) const {
+    if (phase >= PHASE_COUNT || _loops == 0) {
+        return 0;
+    }
+
+    return _total[phase] / _loops;
+}
+
+uint16_t LoopProfiler::count(uint8_t phase, uint8_t bucket) const {
+    if (phase >= PHASE_COUNT || bucket >= BUCKET_COUNT) {
+        return 0;
+    }
+
+    return _buckets[phase * BUCKET_COUNT + bucket];
+}
+
+void LoopProfiler::finish() {
+    _current[PHASE_LOOP] = micros() - _startMicros;
+    for (uint8_t phase = 0; phase < PHASE_COUNT; ++phase) {
+        uint32_t us = _current[phase];
+        _total[phase] += us;
+        if (_maximum[phase] < us) {
+            _maximum[phase] = us;
+        }
+
+        uint8_t bucket = 0;
+        while (us > 0 && bucket < BUCKET_COUNT - 1) {
+            us >>= 1;
+            ++bucket;
+        }
+
+        uint16_t& count = _buckets[phase * BUCKET_COUNT + bucket];
+        if (count < 0xFFFF) {
+            ++count;
+        }
+    }
+
+    ++_loops;
+}
+
+void LoopProfiler::lap(uint8_t phase) {
+    unsigned long now = micros();
+    if (phase < PHASE_LOOP) {
+        _current[phase] += now - _lapMicros;
+    }
+
+    _lapMicros = now;
+}
+
+uint32_t LoopProfiler::maximum(uint8_t phase) const {
+    if (phase >= PHASE_COUNT) {
+        return 0;
+    }
+
+    return _maximum[phase];
+}
+
+const char* LoopProfiler::phaseName(uint8_t phase) {
+    if (phase >= PHASE_COUNT) {
+        return "";
+    }
+
+    return PHASE_NAMES[phase];
+}
+
+void LoopProfiler::print() const {
+    Serial.print("loops ");
+    Serial.println(_loops);
+    Serial.println("phase avg max | <1 <2 <4 <8 <16 <32 <64 <128 <256 <512 <1k <2k <4k <8k <16k >=16k us");
+    for (uint8_t phase = 0; phase < PHASE_COUNT; ++phase) {
+        Serial.print(PHASE_NAMES[phase]);
+        Serial.print(' ');
+        Serial.print(average(phase));
+        Serial.print(' ');
+        Serial.print(_maximum[phase]);
+        Serial.print(" |");
+        for (uint8_t bucket = 0; bucket < BUCKET_COUNT; ++bucket) {
+            Serial.print(' ');
+            Serial.print(count(phase, bucket));
+        }
+
+        Serial.println();
+    }
+}
+
+void LoopProfiler::reset() {
+    for (uint8_t phase = 0; phase < PHASE_COUNT; ++phase) {
+        _current[phase] = 0;
+        _maximum[phase] = 0;
+        _total[phase] = 0;
+    }
+
+    for (uint16_t i = 0; i < PHASE_COUNT * BUCKET_COUNT; ++i) {
+        _buckets[i] = 0;
+    }
+
+    _loops = 0;
+}
+
+void LoopProfiler::start() {
+    for (uint8_t phase = 0; phase < PHASE_COUNT; ++phase) {
+        _current[phase] = 0;
+    }
+
+    _startMicros = micros();
+    _lapMicros = _startMicros;
+}
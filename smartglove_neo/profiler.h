@@ -0,0 +1,83 @@
+/*
+ * Copyright (C) 2026 by Stefan Rothe
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <Arduino.h>
+
+/******************************************************************************
+ * class LoopProfiler
+ *****************************************************************************/
+
+#define PHASE_BUTTONS    0
+#define PHASE_IMU        1
+#define PHASE_SENSORS    2
+#define PHASE_BEHAVIOUR  3
+#define PHASE_SERIAL     4
+#define PHASE_DISPLAY    5
+#define PHASE_I2C        6
+#define PHASE_LOOP       7
+
+class LoopProfiler {
+public:
+    static const uint8_t PHASE_COUNT;
+    static const uint8_t BUCKET_COUNT;
+    LoopProfiler();
+
+    /**
+     * Returns the average time per loop spent in the phase in microseconds.
+     */
+    uint32_t average(uint8_t phase) const;
+
+    /**
+     * Returns the number of loops in which the time spent in the phase falls
+     * into the bucket. Bucket 0 counts loops below 1 us, bucket n loops
+     * between 2^(n-1) and 2^n - 1 us. The last bucket counts all longer loops.
+     */
+    uint16_t count(uint8_t phase, uint8_t bucket) const;
+
+    /**
+     * Ends a loop and adds the time spent in each phase to the statistics.
+     */
+    void finish();
+
+    /**
+     * Attributes the time since the last call to lap() or start() to the phase.
+     */
+    void lap(uint8_t phase);
+
+    inline uint32_t loops() const { return _loops; }
+    uint32_t maximum(uint8_t phase) const;
+    static const char* phaseName(uint8_t phase);
+    void print() const;
+    void reset();
+    void start();
+private:
+    LoopProfiler(const LoopProfiler&);
+    LoopProfiler& operator=(const LoopProfiler&);
+
+    uint16_t* _buckets;
+    uint32_t _current[PHASE_LOOP + 1];
+    unsigned long _lapMicros;
+    uint32_t _loops;
+    uint32_t _maximum[PHASE_LOOP + 1];
+    unsigned long _startMicros;
+    uint64_t _total[PHASE_LOOP + 1];
+};
+
+#endif
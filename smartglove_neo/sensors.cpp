@@ -75,10 +75,19 @@ class Sensor {
 public:
     Sensor();
     bool activity() const;
-    void addMeasurement(unsigned long time, double value);
-    void configure(double min, double max, double minStdDev);
+    void addMeasurement(unsigned long time, int32_t value, bool valid = true);
+    void configure(int32_t min, int32_t max, uint16_t minStdDev);
+    void configureInvalid(uint16_t holdMs, uint16_t decayMs);
+    inline void setGestureTimeout(uint16_t ms) { _gestureTimeoutMs = ms; }
     bool gestureDetected(uint8_t gestureMask) const;
+    inline uint16_t lastValue() const { return _values[_pos]; }
+    inline uint16_t mean() const { return _mean; }
+    inline uint16_t minStdDev() const { return _minStdDev; }
+    inline int32_t rawValue() const { return _rawValue; }
+    inline uint32_t rejected() const { return _rejected; }
+    inline bool valid() const { return _valid; }
     uint16_t value() const;
+    inline uint32_t variance() const { return _variance; }
 private:
     Sensor(const Sensor&);
     Sensor& operator=(const Sensor&);
@@ -87,23 +96,35 @@ private:
     static const uint16_t MAX_VALUE;
     static const uint16_t ZERO_VALUE;
     static const uint8_t VALUE_COUNT;
+    int32_t replacement(unsigned long time) const;
     bool _activity;
-    uint64_t _activityThreshold;
-    double _factor;
+    uint32_t _activityThreshold;
+    uint16_t _decayMs;
+    uint32_t _factor;
     uint8_t _gesture;
     unsigned long _gestureTimeout;
-    uint64_t _mean;
+    uint16_t _gestureTimeoutMs;
+    uint16_t _holdMs;
+    uint16_t _mean;
+    uint16_t _minStdDev;
     uint8_t _pos;
-    double _rawMax;
-    double _rawMin;
+    int32_t _rawMax;
+    int32_t _rawMin;
+    int32_t _rawValue;
+    uint32_t _rejected;
+    uint32_t _sum;
+    uint64_t _sumOfSquares;
     unsigned long _timeMax;
     unsigned long _timeMin;
     char _type;
+    bool _valid;
+    unsigned long _validMs;
+    int32_t _validValue;
     uint16_t _value;
     uint16_t _valueMax;
     uint16_t _valueMin;
     uint16_t* _values;
-    int64_t _variance;
+    uint32_t _variance;
 };
 
 const uint16_t Sensor::GESTURE_THRESOLD = 10;
@@ -114,20 +135,35 @@ const uint8_t Sensor::VALUE_COUNT = 16;
 Sensor::Sensor() :
     _activity(false),
     _activityThreshold(0),
-    _factor(1.0),
+    _decayMs(0),
+    _factor(1 << 16),
     _gesture(0),
     _gestureTimeout(0),
+    _gestureTimeoutMs(GESTURE_TIMEOUT_MS),
+    _holdMs(SENSOR_HOLD_FOREVER),
+    _mean(ZERO_VALUE),
+    _minStdDev(0),
     _pos(0),
     _timeMin(0),
     _timeMax(0),
-    _rawMax(1.0),
-    _rawMin(-1.0),
+    _rawMax(1),
+    _rawMin(-1),
+    _rawValue(0),
+    _rejected(0),
+    _sum(0),
+    _sumOfSquares(0),
+    _valid(true),
+    _validMs(0),
+    _validValue(0),
     _value(ZERO_VALUE),
     _valueMax(MAX_VALUE),
     _valueMin(0),
-    _values(new uint16_t[VALUE_COUNT]) {
+    _values(new uint16_t[VALUE_COUNT]),
+    _variance(0) {
     for (int i = 0; i < VALUE_COUNT; ++i) {
         _values[i] = ZERO_VALUE;
+        _sum += ZERO_VALUE;
+        _sumOfSquares += static_cast<uint32_t>(ZERO_VALUE) * ZERO_VALUE;
     }
 }
 
@@ -135,7 +171,19 @@ bool Sensor::activity() const {
     return _activity;
 }
 
-void Sensor::addMeasurement(unsigned long time, double value) {
+void Sensor::addMeasurement(unsigned long time, int32_t value, bool valid) {
+    _valid = valid;
+    if (valid) {
+        _validMs = time;
+        _validValue = value;
+    }
+    else {
+        ++_rejected;
+        value = replacement(time);
+    }
+
+    _rawValue = value;
+    uint32_t delta;
     if (_rawMin < _rawMax) {
         if (value < _rawMin) {
             value = _rawMin;
@@ -144,6 +192,8 @@ void Sensor::addMeasurement(unsigned long time, double value) {
         if (value > _rawMax) {
             value = _rawMax;
         }
+
+        delta = value - _rawMin;
     }
     else {
         if (value > _rawMin) {
@@ -153,25 +203,25 @@ void Sensor::addMeasurement(unsigned long time, double value) {
         if (value < _rawMax) {
             value = _rawMax;
         }
+
+        delta = _rawMin - value;
     }
 
-    // scale raw measurement
-    uint16_t currentValue = (value - _rawMin) * _factor;
-    // add measurement to ring buffer
+    // scale raw measurement, delta * _factor is at most MAX_VALUE << 16
+    uint16_t currentValue = (delta * _factor) >> 16;
+    // add measurement to ring buffer, replacing the oldest value in the
+    // running sums
     _pos = (_pos + 1) % VALUE_COUNT;
+    uint16_t oldValue = _values[_pos];
     _values[_pos] = currentValue;
-
-    // calculate variance for activity detection
-    uint64_t sum = 0;
-    uint64_t sumOfSquares = 0;
-    for (uint8_t i = 0; i < VALUE_COUNT; ++i) {
-        uint64_t val = _values[i];
-        sum += val;
-        sumOfSquares += val * val;
-    }
-
-    _mean = sum / VALUE_COUNT;
-    _variance = sumOfSquares / VALUE_COUNT - _mean * _mean;
+    _sum = _sum - oldValue + currentValue;
+    _sumOfSquares -= static_cast<uint32_t>(oldValue) * oldValue;
+    _sumOfSquares += static_cast<uint32_t>(currentValue) * currentValue;
+
+    // calculate variance for activity detection, both terms fit into 32 bits
+    _mean = _sum / VALUE_COUNT;
+    _variance = static_cast<uint32_t>(_sumOfSquares / VALUE_COUNT) -
+                static_cast<uint32_t>(_mean) * _mean;
     _activity = _activityThreshold < _variance;
     if (!_activity) {
         _gesture = 0;
@@ -211,22 +261,52 @@ void Sensor::addMeasurement(unsigned long time, double value) {
     if (_valueMin < GESTURE_THRESOLD && _valueMax > MAX_VALUE - GESTURE_THRESOLD) {
         // gesture detected
         _gesture = _timeMin < _timeMax ? GESTURE_UP : GESTURE_DOWN;
-        _gestureTimeout = time + GESTURE_TIMEOUT_MS;
+        _gestureTimeout = time + _gestureTimeoutMs;
     }
 }
 
-void Sensor::configure(double min, double max, double minStdDev) {
+void Sensor::configure(int32_t min, int32_t max, uint16_t minStdDev) {
+    _minStdDev = minStdDev;
     _rawMin = min;
     _rawMax = max;
-    _factor = static_cast<double>(MAX_VALUE) / (_rawMax - _rawMin);
-    _activityThreshold = minStdDev * abs(_factor);
-    _activityThreshold *= _activityThreshold;
+    uint32_t span = min < max ? max - min : min - max;
+    if (span == 0) {
+        span = 1;
+    }
+
+    // Q16 scaling factor from raw units to the full 16 bit range
+    _factor = (static_cast<uint32_t>(MAX_VALUE) << 16) / span;
+    uint64_t threshold = (static_cast<uint64_t>(minStdDev) * _factor) >> 16;
+    threshold *= threshold;
+    // the variance of 16 bit values is always below 2^32
+    _activityThreshold = threshold < 0xFFFFFFFF ? threshold : 0xFFFFFFFF;
+}
+
+void Sensor::configureInvalid(uint16_t holdMs, uint16_t decayMs) {
+    _decayMs = decayMs;
+    _holdMs = holdMs;
 }
 
 bool Sensor::gestureDetected(uint8_t gestureMask) const {
     return (_gesture & gestureMask) == gestureMask;
 }
 
+int32_t Sensor::replacement(unsigned long time) const {
+    unsigned long elapsed = time - _validMs;
+    if (_holdMs == SENSOR_HOLD_FOREVER || elapsed <= _holdMs) {
+        return _validValue;
+    }
+
+    elapsed -= _holdMs;
+    if (elapsed >= _decayMs) {
+        return _rawMax;
+    }
+
+    // linear decay, the product doesn't fit into 32 bits
+    int64_t delta = static_cast<int64_t>(_rawMax - _validValue) * elapsed / _decayMs;
+    return _validValue + static_cast<int32_t>(delta);
+}
+
 uint16_t Sensor::value() const {
     return _value;
 }
@@ -235,7 +315,7 @@ uint16_t Sensor::value() const {
  * class Sensors
  *****************************************************************************/
 
-const uint8_t Sensors::COUNT = 11;
+const uint8_t Sensors::COUNT = SENSOR_COUNT;
 const uint8_t Sensors::GESTURE_COUNT = 4;
 
 Sensors::Sensors() :
@@ -255,12 +335,12 @@ bool Sensors::activity(uint8_t id) const {
     return _sensors[id].activity();
 }
 
-void Sensors::addMeasurement(unsigned long time, uint8_t id, double value) {
+void Sensors::addMeasurement(unsigned long time, uint8_t id, int32_t value, bool valid) {
     if (id >= COUNT) {
         return;
     }
 
-    _sensors[id].addMeasurement(time, value);
+    _sensors[id].addMeasurement(time, value, valid);
 }
 
 bool Sensors::available(uint8_t id) const {
@@ -271,7 +351,7 @@ bool Sensors::available(uint8_t id) const {
     return _available & (1 << id);
 }
 
-void Sensors::configure(uint8_t id, double min, double max, double minStdDev) {
+void Sensors::configure(uint8_t id, int32_t min, int32_t max, uint16_t minStdDev) {
     if (id >= COUNT) {
         return;
     }
@@ -279,6 +359,14 @@ void Sensors::configure(uint8_t id, double min, double max, double minStdDev) {
     _sensors[id].configure(min, max, minStdDev);
 }
 
+void Sensors::configureInvalid(uint8_t id, uint16_t holdMs, uint16_t decayMs) {
+    if (id >= COUNT) {
+        return;
+    }
+
+    _sensors[id].configureInvalid(holdMs, decayMs);
+}
+
 bool Sensors::gestureAvailable(uint8_t id) const {
     return id < GESTURE_COUNT;
 }
@@ -306,6 +394,14 @@ uint16_t Sensors::maxValue(uint8_t id) const {
     return _sensors[id]._valueMax;
 }
 
+uint16_t Sensors::minStdDev(uint8_t id) const {
+    if (id >= COUNT) {
+        return 0;
+    }
+
+    return _sensors[id].minStdDev();
+}
+
 uint16_t Sensors::minValue(uint8_t id) const {
     if (id >= COUNT) {
         return 0;
@@ -314,10 +410,40 @@ uint16_t Sensors::minValue(uint8_t id) const {
     return _sensors[id]._valueMin;
 }
 
+int32_t Sensors::rawValue(uint8_t id) const {
+    if (id >= COUNT) {
+        return 0;
+    }
+
+    return _sensors[id].rawValue();
+}
+
+uint32_t Sensors::rejected(uint8_t id) const {
+    if (id >= COUNT) {
+        return 0;
+    }
+
+    return _sensors[id].rejected();
+}
+
+void Sensors::setGestureTimeout(uint16_t ms) {
+    for (uint8_t i = 0; i < COUNT; ++i) {
+        _sensors[i].setGestureTimeout(ms);
+    }
+}
+
 void Sensors::setAvailable(uint16_t mask) {
     _available = mask;
 }
 
+bool Sensors::valid(uint8_t id) const {
+    if (id >= COUNT) {
+        return false;
+    }
+
+    return _sensors[id].valid();
+}
+
 uint16_t Sensors::value(uint8_t id) const {
     if (id >= COUNT) {
         return 0;
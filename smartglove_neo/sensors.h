@@ -70,6 +70,16 @@ private:
 #define SENSOR_GYRO_ROLL           8
 #define SENSOR_GYRO_PITCH          9
 #define SENSOR_GYRO_HEADING       10
+// zones of the distance sensor in the zones profile
+#define SENSOR_DISTANCE_ZONE_1    11
+#define SENSOR_DISTANCE_ZONE_2    12
+#define SENSOR_DISTANCE_ZONE_3    13
+#define SENSOR_DISTANCE_ZONE_COUNT 3
+#define SENSOR_COUNT              14
+
+// invalid measurements are replaced by the last valid one, see
+// Sensors::configureInvalid()
+#define SENSOR_HOLD_FOREVER 0xFFFF
 
 #define GESTURE_WAVE_LEFT 0
 #define GESTURE_WAVE_RIGHT 1
@@ -85,14 +95,50 @@ public:
     Sensors();
     ~Sensors();
     bool activity(uint8_t id) const;
-    void addMeasurement(unsigned long time, uint8_t id, double value);
+
+    /**
+     * Adds a measurement in raw units. An invalid measurement is counted and
+     * replaced, see configureInvalid(), so that it neither shows up in the
+     * value nor triggers activity.
+     */
+    void addMeasurement(unsigned long time, uint8_t id, int32_t value, bool valid = true);
     bool available(uint8_t id) const;
-    void configure(uint8_t id, double min, double max, double minStdDev);
+
+    /**
+     * Configures the range of a sensor in raw units. min is mapped to 0, max
+     * to 0xFFFF, min may be larger than max. Activity is detected if the
+     * standard deviation of the recent values exceeds minStdDev.
+     */
+    void configure(uint8_t id, int32_t min, int32_t max, uint16_t minStdDev);
+
+    /**
+     * Configures the replacement of invalid measurements. The last valid
+     * measurement is repeated for holdMs, then the replacement moves to the
+     * max of the raw range, see configure(), within decayMs. With
+     * SENSOR_HOLD_FOREVER, the default, the last valid measurement is
+     * repeated until the next one.
+     */
+    void configureInvalid(uint8_t id, uint16_t holdMs, uint16_t decayMs);
     bool gestureAvailable(uint8_t id) const;
     bool gestureDetected(uint8_t id) const;
     uint16_t maxValue(uint8_t id) const;
+    uint16_t minStdDev(uint8_t id) const;
     uint16_t minValue(uint8_t id) const;
+
+    /**
+     * Returns the last measurement of a sensor in raw units, before it has
+     * been limited to the configured range. Invalid measurements have been
+     * replaced.
+     */
+    int32_t rawValue(uint8_t id) const;
+
+    /**
+     * Returns the number of invalid measurements of a sensor.
+     */
+    uint32_t rejected(uint8_t id) const;
     void setAvailable(uint16_t mask);
+    void setGestureTimeout(uint16_t ms);
+    bool valid(uint8_t id) const;
     uint16_t value(uint8_t id) const;
 private:
     Sensors(const Sensors&);
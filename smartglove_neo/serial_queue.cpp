@@ -0,0 +1,97 @@
+/*
+ * Copyright (C) 2026 by Stefan Rothe
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "serial_queue.h"
+
+const uint8_t SerialQueue::CAPACITY = 128;
+// one USB full speed bulk packet
+const uint8_t SerialQueue::SLICE = 64;
+
+SerialQueue::SerialQueue() :
+    _back(new uint8_t[CAPACITY]),
+    _backLength(0),
+    _dropped(0),
+    _front(new uint8_t[CAPACITY]),
+    _frontLength(0),
+    _frontPos(0) {
+}
+
+SerialQueue::~SerialQueue() {
+    delete[] _back;
+    delete[] _front;
+}
+
+bool SerialQueue::beginFrame(uint8_t size) {
+    if (CAPACITY - _backLength < size) {
+        ++_dropped;
+        return false;
+    }
+
+    return true;
+}
+
+void SerialQueue::clear() {
+    _backLength = 0;
+    _frontLength = 0;
+    _frontPos = 0;
+}
+
+void SerialQueue::loop() {
+    if (_frontPos == _frontLength) {
+        if (_backLength == 0) {
+            return;
+        }
+
+        // front buffer has been sent, swap buffers
+        uint8_t* buffer = _front;
+        _front = _back;
+        _frontLength = _backLength;
+        _frontPos = 0;
+        _back = buffer;
+        _backLength = 0;
+    }
+
+    // the SAMD21 core reports the endpoint size here, not the free space
+    int available = Serial.availableForWrite();
+    if (available <= 0) {
+        return;
+    }
+
+    uint8_t length = _frontLength - _frontPos;
+    if (length > SLICE) {
+        length = SLICE;
+    }
+
+    if (available < length) {
+        length = available;
+    }
+
+    Serial.write(_front + _frontPos, length);
+    _frontPos += length;
+}
+
+void SerialQueue::write(uint8_t data) {
+    if (_backLength < CAPACITY) {
+        _back[_backLength] = data;
+        ++_backLength;
+    }
+}
+
+void SerialQueue::write16(uint16_t data) {
+    write(data >> 8);
+    write(data & 0xFF);
+}
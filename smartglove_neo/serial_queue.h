@@ -0,0 +1,82 @@
+/*
+ * Copyright (C) 2026 by Stefan Rothe
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SERIAL_QUEUE_H
+#define SERIAL_QUEUE_H
+
+#include <Arduino.h>
+
+/******************************************************************************
+ * class SerialQueue
+ *
+ * Double buffered transmit queue for the serial port. Frames are assembled
+ * in the back buffer while the front buffer is handed to the serial port in
+ * slices of at most SLICE bytes per loop. On the SAMD21, write() blocks
+ * while the host is not reading, the time spent is recorded in the serial
+ * phase of the loop profiler.
+ *****************************************************************************/
+
+class SerialQueue {
+public:
+    static const uint8_t CAPACITY;
+    static const uint8_t SLICE;
+
+    SerialQueue();
+    ~SerialQueue();
+
+    /**
+     * Starts a new frame of the given size. Returns false if the frame does
+     * not fit into the back buffer. In this case the frame is dropped and
+     * must not be written.
+     */
+    bool beginFrame(uint8_t size);
+
+    /**
+     * Discards all queued data.
+     */
+    void clear();
+
+    /**
+     * Returns the number of frames dropped because the queue was full.
+     */
+    inline uint16_t dropped() const { return _dropped; }
+
+    /**
+     * Returns true if all queued data has been handed to the serial port.
+     */
+    inline bool empty() const { return _frontPos == _frontLength && _backLength == 0; }
+
+    /**
+     * Hands up to SLICE bytes of queued data to the serial port, less if
+     * availableForWrite() reports less.
+     */
+    void loop();
+    void write(uint8_t data);
+    void write16(uint16_t data);
+private:
+    SerialQueue(const SerialQueue&);
+    SerialQueue& operator=(const SerialQueue&);
+
+    uint8_t* _back;
+    uint8_t _backLength;
+    uint16_t _dropped;
+    uint8_t* _front;
+    uint8_t _frontLength;
+    uint8_t _frontPos;
+};
+
+#endif
@@ -32,7 +32,9 @@ const uint8_t BUTTON_MAP[BUTTON_COUNT] = {
 SmartBall::SmartBall() :
     _buttons(I2C_SMART_BALL_BUTTONS_ADDRESS),
     _commandMenu(false),
-    _menuTimeoutMs(0) {
+    _commandNextPreset(false),
+    _menuTimeoutMs(0),
+    _presetTimeoutMs(0) {
 }
 
 bool SmartBall::commandCalibrateIMU() const {
@@ -51,6 +53,10 @@ bool SmartBall::commandMenu() const {
     return _commandMenu;
 }
 
+bool SmartBall::commandNextPreset() const {
+    return _commandNextPreset;
+}
+
 bool SmartBall::commandUp() const {
     return buttonDown(BUTTON_INDEX_FINGER_1);
 }
@@ -67,6 +73,7 @@ void SmartBall::doSetup() {
 void SmartBall::doLoop() {
     unsigned long now = millis();
     _commandMenu = false;
+    _commandNextPreset = false;
     if (buttonCombination(BUTTON_THUMB_1, BUTTON_LITTLE_FINGER_1)) {
         _menuTimeoutMs = now + LONG_PRESS_MS;
     }
@@ -80,6 +87,17 @@ void SmartBall::doLoop() {
     else {
         _menuTimeoutMs = now + LONG_PRESS_MS;
     }
+
+    // both buttons are streamed to the host, only a long press switches
+    if (buttonPressed(BUTTON_RING_FINGER_1) && buttonPressed(BUTTON_LITTLE_FINGER_1)) {
+        if (_presetTimeoutMs < now) {
+            _commandNextPreset = true;
+            _presetTimeoutMs = now + LONG_PRESS_MS;
+        }
+    }
+    else {
+        _presetTimeoutMs = now + LONG_PRESS_MS;
+    }
 }
 
 uint16_t SmartBall::availableButtonMask() const {
@@ -103,9 +121,9 @@ uint16_t SmartBall::availableSensorMask() const {
         (1 << SENSOR_GYRO_HEADING);
 }
 
-uint16_t SmartBall::readButtonState() const {
+uint16_t SmartBall::readButtonState() {
     uint16_t result = 0;
-    uint8_t buttons = _buttons.readInput();
+    uint8_t buttons = _buttons.input();
     for (uint8_t bit = 0; bit < BUTTON_COUNT; ++bit) {
         if (buttons & (1 << bit)) {
             result |= (1 << BUTTON_MAP[bit]);
@@ -115,6 +133,10 @@ uint16_t SmartBall::readButtonState() const {
     return result;
 }
 
+void SmartBall::requestInputs() {
+    _buttons.requestInput();
+}
+
 void SmartBall::setInfoLED(bool on) {
-    _buttons.writeOutput(on ? 0x80 : 0x00);
+    _buttons.queueOutput(on ? 0x80 : 0x00);
 }
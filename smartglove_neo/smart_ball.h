@@ -28,6 +28,7 @@ public:
     virtual bool commandDown() const;
     virtual bool commandEnter() const;
     virtual bool commandMenu() const;
+    virtual bool commandNextPreset() const;
     virtual bool commandUp() const;
     virtual bool flexReady() const;
 protected:
@@ -35,12 +36,15 @@ protected:
     virtual void doLoop();
     virtual uint16_t availableButtonMask() const;
     virtual uint16_t availableSensorMask() const;
-    virtual uint16_t readButtonState() const;
+    virtual uint16_t readButtonState();
+    virtual void requestInputs();
     virtual void setInfoLED(bool on);
 private:
     PCA9557 _buttons;
     bool _commandMenu;
+    bool _commandNextPreset;
     unsigned long _menuTimeoutMs;
+    unsigned long _presetTimeoutMs;
 };
 
 #endif
@@ -19,8 +19,18 @@
 #include "smart_device.h"
 #include "behaviour.h"
 #include "config.h"
+#include "i2c_master.h"
+#include "i2c_queue.h"
 #include "storage.h"
 
+#define NO_PRESET 0xFF
+
+static int32_t clampToRange(int32_t value, int32_t end1, int32_t end2) {
+    int32_t low = end1 < end2 ? end1 : end2;
+    int32_t high = end1 < end2 ? end2 : end1;
+    return value < low ? low : (value > high ? high : value);
+}
+
 /******************************************************************************
  * class LED
  *****************************************************************************/
@@ -132,9 +142,19 @@ SmartDevice::SmartDevice() :
     _debugSerial(false),
     _display(I2C_DISPLAY_ADDRESS),
     _imu(-1, I2C_IMU_ADDRESS),
+    _imuData(I2C_IMU_ADDRESS),
     _imuReady(false),
     _infoLED(),
-    _sensors() {
+    _lastLoopUs(0),
+    _lastNeoPixelMs(0),
+    _lastRenderMs(0),
+    _nextLoopUs(0),
+    _nextPreset(NO_PRESET),
+    _renderFrame(true),
+    _sensorConfigured(0),
+    _sensorLimited(0),
+    _sensors(),
+    _serialQueue() {
 }
 
 bool SmartDevice::buttonCombination(uint8_t id1, uint8_t id2) const {
@@ -142,12 +162,37 @@ bool SmartDevice::buttonCombination(uint8_t id1, uint8_t id2) const {
            (buttonDown(id2) && buttonPressed(id1));
 }
 
-void SmartDevice::configureSensor(uint8_t index, double min, double max, double minStdDev) {
-    _sensors.configure(index, min, max, minStdDev);
+void SmartDevice::calibrateSensor(uint8_t id, int32_t min, int32_t max) {
+    Storage.setCalibration(id, min, max);
+    applySensorConfig(id);
+}
+
+void SmartDevice::configureSensor(uint8_t index, int32_t min, int32_t max, uint16_t minStdDev,
+                                  bool limitCalibration) {
+    if (index >= SENSOR_COUNT) {
+        return;
+    }
+
+    // the default configuration, the active preset is applied on top
+    _sensorConfigured |= 1 << index;
+    if (limitCalibration) {
+        _sensorLimited |= 1 << index;
+    }
+    else {
+        _sensorLimited &= ~(1 << index);
+    }
+
+    _sensorMax[index] = max;
+    _sensorMin[index] = min;
+    _sensorMinStdDev[index] = minStdDev;
+    applySensorConfig(index);
 }
 
 void SmartDevice::setup() {
     Wire.begin();
+    Wire.setClock(I2C_CLOCK_HZ);
+    I2CMaster.begin();
+    Storage.begin();
     // initialize buttons
     _buttons.setAvailable(availableButtonMask());
     _sensors.setAvailable(availableSensorMask());
@@ -159,20 +204,23 @@ void SmartDevice::setup() {
     }
     else {
         _infoLED.setMode(LED::Off);
-        _display.setFont(&HELVETICA_18);
+        _display.setFont(&FONT_LARGE);
     }
 
     setInfoLED(_infoLED.on());
+    I2CQueue.loop();
 
     _showFramerate = Storage.showFramerate();
+    _sensors.setGestureTimeout(Storage.gestureTimeoutMs());
 
-    configureSensor(SENSOR_ACCEL_X, -10.0, 10.0, 0.2);
-    configureSensor(SENSOR_ACCEL_Y, 10.0, -10.0, 0.2);
-    configureSensor(SENSOR_ACCEL_Z, 10.0, -10.0, 0.2);
-    configureSensor(SENSOR_DISTANCE, 0, 2000, 2.0);
-    configureSensor(SENSOR_GYRO_ROLL, 180.0, -180.0, 2.0);
-    configureSensor(SENSOR_GYRO_PITCH, 90.0, -90.0, 1.0);
-    configureSensor(SENSOR_GYRO_HEADING, 180.0, -180.0, 2.0);
+    // ranges in raw units of the IMU, the distance sensor is configured by
+    // the SmartGlove according to its ranging profile
+    configureSensor(SENSOR_ACCEL_X, -10 * IMU::ACCEL_LSB, 10 * IMU::ACCEL_LSB, IMU::ACCEL_LSB / 5);
+    configureSensor(SENSOR_ACCEL_Y, 10 * IMU::ACCEL_LSB, -10 * IMU::ACCEL_LSB, IMU::ACCEL_LSB / 5);
+    configureSensor(SENSOR_ACCEL_Z, 10 * IMU::ACCEL_LSB, -10 * IMU::ACCEL_LSB, IMU::ACCEL_LSB / 5);
+    configureSensor(SENSOR_GYRO_ROLL, 180 * IMU::EULER_LSB, -180 * IMU::EULER_LSB, 2 * IMU::EULER_LSB);
+    configureSensor(SENSOR_GYRO_PITCH, 90 * IMU::EULER_LSB, -90 * IMU::EULER_LSB, IMU::EULER_LSB);
+    configureSensor(SENSOR_GYRO_HEADING, 180 * IMU::EULER_LSB, -180 * IMU::EULER_LSB, 2 * IMU::EULER_LSB);
 
     // initialize behaviour
     _behaviour.setup();
@@ -183,53 +231,158 @@ void SmartDevice::setup() {
     doSetup();
 }
 
-unsigned long last;
-
 void SmartDevice::loop() {
+    // run sensor acquisition and protocol output at a fixed rate
+    unsigned long nowUs = micros();
+    if (static_cast<long>(nowUs - _nextLoopUs) < 0) {
+        return;
+    }
+
+    _nextLoopUs += LOOP_INTERVAL_US;
+    if (static_cast<long>(nowUs - _nextLoopUs) >= 0) {
+        // overrun, don't try to catch up
+        _nextLoopUs = nowUs + LOOP_INTERVAL_US;
+    }
+
+    _profiler.start();
+    if (_nextPreset != NO_PRESET) {
+        // between two frames, without touching the I2C devices
+        Storage.setPreset(_nextPreset);
+        applyPresetSettings();
+        _nextPreset = NO_PRESET;
+    }
+
     unsigned long now = millis();
+    // the display is redrawn at a lower rate, see renderFrame()
+    _renderFrame = now - _lastRenderMs >= DISPLAY_INTERVAL_MS && !_display.busy();
+
     _infoLED.loop();
     setInfoLED(_infoLED.on());
+    // all inputs are read in one go, highest priority first
+    requestInputs();
+    if (_imuReady) {
+        _imuData.requestVectors();
+    }
+
+    // display and EEPROM transfers left over from the last loop wait. The
+    // distance sensor is read in the background while the buttons and the
+    // IMU are processed.
+    I2CQueue.loop(I2C_PRIORITY_HIGH);
+    I2CQueue.poll(I2C_PRIORITY_MEDIUM);
+    _profiler.lap(PHASE_I2C);
     // update buttons
     _buttons.updateState(readButtonState());
+    _profiler.lap(PHASE_BUTTONS);
     // update sensor values from IMU
     if (_imuReady) {
-        _imu.getEvent(&_imuEvent);
-        _imuAcceleration = _imu.getVector(Adafruit_BNO055::VECTOR_LINEARACCEL);
-        _sensors.addMeasurement(now, SENSOR_ACCEL_X, _imuAcceleration.x());
-        _sensors.addMeasurement(now, SENSOR_ACCEL_Y, _imuAcceleration.y());
-        _sensors.addMeasurement(now, SENSOR_ACCEL_Z, _imuAcceleration.z());
-        double heading = _imuEvent.orientation.x;
-        if (heading > 180) {
-            heading -= 360;
+        int16_t euler[3];
+        int16_t acceleration[3];
+        _imuData.euler(euler);
+        _imuData.linearAcceleration(acceleration);
+        _sensors.addMeasurement(now, SENSOR_ACCEL_X, acceleration[0]);
+        _sensors.addMeasurement(now, SENSOR_ACCEL_Y, acceleration[1]);
+        _sensors.addMeasurement(now, SENSOR_ACCEL_Z, acceleration[2]);
+        int32_t heading = euler[0];
+        if (heading > 180 * IMU::EULER_LSB) {
+            heading -= 360 * IMU::EULER_LSB;
         }
 
         _sensors.addMeasurement(now, SENSOR_GYRO_HEADING, heading);
-        _sensors.addMeasurement(now, SENSOR_GYRO_PITCH, _imuEvent.orientation.y);
-        _sensors.addMeasurement(now, SENSOR_GYRO_ROLL, _imuEvent.orientation.z);
+        _sensors.addMeasurement(now, SENSOR_GYRO_PITCH, euler[1]);
+        _sensors.addMeasurement(now, SENSOR_GYRO_ROLL, euler[2]);
     }
 
-
+    _profiler.lap(PHASE_IMU);
+    I2CQueue.loop(I2C_PRIORITY_MEDIUM);
+    _profiler.lap(PHASE_I2C);
     doLoop();
-    _display.clear();
+    _profiler.lap(PHASE_SENSORS);
+    if (_renderFrame) {
+        _display.clear();
+    }
+
     _behaviour.loop();
     if (buttonCombination(BUTTON_INDEX_FINGER_2, BUTTON_MIDDLE_FINGER_2)) {
         resetIMU();
     }
 
-    if (_showFramerate) {
-        unsigned long now = millis();
+    if (commandNextPreset()) {
+        selectPreset((Storage.preset() + 1) % STORAGE_PRESET_COUNT);
+    }
+
+    unsigned long loopUs = nowUs - _lastLoopUs;
+    _lastLoopUs = nowUs;
+    if (_showFramerate && _renderFrame && loopUs > 0) {
         char text[6];
-        sprintf(text, "%i", 1000 / (now - _lastMs));
-        _lastMs = now;
-        Font* oldFont = _display.font();
-        _display.setFont(&HELVETICA_8);
-        _display.setTextAlign(ALIGN_LEFT);
-        _display.drawText(115, 7, text);
+        sprintf(text, "%lu", 1000000 / loopUs);
+        const Font* oldFont = _display.font();
+        _display.setFont(&FONT_SMALL);
+        _display.setTextAlign(ALIGN_RIGHT);
+        _display.drawText(Display::WIDTH, 7, text);
         _display.setFont(oldFont);
     }
 
-    _display.updatePage();
-    last = now;
+    _profiler.lap(PHASE_BEHAVIOUR);
+    // outputs of this loop are written while the serial data is sent
+    I2CQueue.poll(I2C_PRIORITY_MEDIUM);
+    _serialQueue.loop();
+    _profiler.lap(PHASE_SERIAL);
+    Storage.loop();
+    // NeoPixel changes of this loop are shown together, at a limited rate
+    if (now - _lastNeoPixelMs >= NEOPIXEL_INTERVAL_MS && showNeoPixels()) {
+        _lastNeoPixelMs = now;
+    }
+
+    if (_renderFrame) {
+        // only starts the transfer, the next frame is rendered when it is done
+        _display.flush();
+        _lastRenderMs = now;
+    }
+
+    _profiler.lap(PHASE_DISPLAY);
+    // remaining outputs of this loop, then display and EEPROM transfers in
+    // the time left until the next loop
+    I2CQueue.loop(I2C_PRIORITY_MEDIUM);
+    long budgetUs = static_cast<long>(_nextLoopUs - micros()) - I2C_BACKGROUND_MARGIN_US;
+    if (budgetUs > 0) {
+        I2CQueue.loop(I2C_PRIORITY_LOW, budgetUs);
+    }
+
+    _profiler.lap(PHASE_I2C);
+    _profiler.finish();
+}
+
+void SmartDevice::applyPresetSettings() {
+    _sensors.setGestureTimeout(Storage.gestureTimeoutMs());
+    for (uint8_t id = 0; id < SENSOR_COUNT; ++id) {
+        if (_sensorConfigured & (1 << id)) {
+            applySensorConfig(id);
+        }
+    }
+}
+
+void SmartDevice::applySensorConfig(uint8_t id) {
+    int32_t min = _sensorMin[id];
+    int32_t max = _sensorMax[id];
+    if (Storage.calibrated(id)) {
+        int32_t low = Storage.calibrationMin(id);
+        int32_t high = Storage.calibrationMax(id);
+        if (_sensorLimited & (1 << id)) {
+            low = clampToRange(low, min, max);
+            high = clampToRange(high, min, max);
+        }
+
+        // calibrated ranges keep the direction of the default range, a
+        // calibration outside of a limited range is ignored
+        if (low != high) {
+            bool reversed = min > max;
+            min = reversed ? high : low;
+            max = reversed ? low : high;
+        }
+    }
+
+    uint32_t minStdDev = static_cast<uint32_t>(_sensorMinStdDev[id]) * Storage.activityScale() / 100;
+    _sensors.configure(id, min, max, minStdDev < 0xFFFF ? minStdDev : 0xFFFF);
 }
 
 void SmartDevice::popBehaviour() {
@@ -240,7 +393,15 @@ void SmartDevice::pushBehaviour(Behaviour* behaviour) {
     _behaviour.push(behaviour);
 }
 
+void SmartDevice::selectPreset(uint8_t index) {
+    if (index < STORAGE_PRESET_COUNT) {
+        _nextPreset = index;
+    }
+}
+
 bool SmartDevice::resetIMU() {
+    // the Adafruit library accesses Wire directly
+    I2CMaster.wait();
     _imuReady = _imu.begin(Adafruit_BNO055::OPERATION_MODE_IMUPLUS);
     return _imuReady;
 }
@@ -268,6 +429,51 @@ void SmartDevice::setLED(LED::Mode mode) {
     _infoLED.setMode(mode);
 }
 
+void SmartDevice::setNeoPixelFrame(const uint8_t* data, uint8_t length) {
+    if (length < 2 || data[1] > NEOPIXEL_FRAME_RLE) {
+        return;
+    }
+
+    uint8_t firstFinger = NEOPIXEL_FIRST_FINGER;
+    uint8_t lastFinger = NEOPIXEL_LAST_FINGER;
+    if (data[0] != NEOPIXEL_FRAME_ALL) {
+        if (data[0] < NEOPIXEL_FIRST_FINGER || data[0] > NEOPIXEL_LAST_FINGER) {
+            return;
+        }
+
+        firstFinger = data[0];
+        lastFinger = data[0];
+    }
+
+    bool runLength = data[1] == NEOPIXEL_FRAME_RLE;
+    uint8_t pixelCount = (lastFinger - firstFinger + 1) * NEOPIXEL_COUNT;
+    uint8_t pixel = 0;
+    uint8_t pos = 2;
+    while (pixel < pixelCount) {
+        uint8_t run = 1;
+        if (runLength) {
+            if (pos >= length) {
+                break;
+            }
+
+            run = data[pos];
+            ++pos;
+        }
+
+        if (pos + 3 > length) {
+            break;
+        }
+
+        for (; run > 0 && pixel < pixelCount; --run) {
+            setNeoPixel(firstFinger + pixel / NEOPIXEL_COUNT, pixel % NEOPIXEL_COUNT + 1,
+                        data[pos], data[pos + 1], data[pos + 2]);
+            ++pixel;
+        }
+
+        pos += 3;
+    }
+}
+
 void SmartDevice::setShowFramerate(bool showFramerate) {
     if (_showFramerate != showFramerate) {
         _showFramerate = showFramerate;
@@ -284,7 +490,7 @@ void SmartDevice::waitForFlash() {
         if (_display.ready()) {
             sprintf(text, "Wait %i", (wait / 1000));
             _display.clear();
-            _display.setFont(&HELVETICA_10);
+            _display.setFont(&FONT_SMALL);
             _display.setTextAlign(ALIGN_LEFT);
             _display.drawText(10, 10, text);
             _display.update();
@@ -19,8 +19,15 @@
 #define SMART_DEVICE_H
 
 #include <Adafruit_BNO055.h>
-#include <ssd1306.h>
+#include "display.h"
+#include "imu.h"
+#include "profiler.h"
 #include "sensors.h"
+#include "serial_queue.h"
+
+#define NEOPIXEL_FRAME_ALL 0
+#define NEOPIXEL_FRAME_RAW 0
+#define NEOPIXEL_FRAME_RLE 1
 
 /******************************************************************************
  * class LED
@@ -96,32 +103,72 @@ public:
     SmartDevice();
     void setup();
     void loop();
+
+    /**
+     * Applies the activity scale, gesture timeout and calibration of the
+     * active preset to the sensors, after one of them has been changed.
+     */
+    void applyPresetSettings();
     inline bool buttonAvailable(uint8_t id) const { return _buttons.available(id); }
     bool buttonCombination(uint8_t id1, uint8_t id2) const;
+
+    /**
+     * Sets the raw range of a sensor and stores it in the EEPROM. The range
+     * replaces the default range of the sensor, also after a restart.
+     */
+    void calibrateSensor(uint8_t id, int32_t min, int32_t max);
     inline bool buttonDown(uint8_t id) const { return _buttons.down(id); }
     inline bool buttonPressed(uint8_t id) const { return _buttons.pressed(id); }
     virtual bool commandCalibrateIMU() const = 0;
     virtual bool commandDown() const = 0;
     virtual bool commandEnter() const = 0;
     virtual bool commandMenu() const = 0;
+    virtual bool commandNextPreset() const = 0;
     virtual bool commandUp() const = 0;
     inline bool debugSerial() const { return _debugSerial; }
-    inline SSD1306& display() { return _display; }
+    inline Display& display() { return _display; }
     virtual bool flexReady() const = 0;
     inline bool gestureAvailable(uint8_t id) const { return _sensors.gestureAvailable(id); }
     inline bool gestureDetected(uint8_t id) const { return _sensors.gestureDetected(id); }
     inline bool imuReady() const { return _imuReady; }
     void popBehaviour();
+    inline LoopProfiler& profiler() { return _profiler; }
     void pushBehaviour(Behaviour* behaviour);
+
+    /**
+     * Returns true if the display is redrawn in the current loop. Behaviours
+     * may skip drawing in all other loops.
+     */
+    inline bool renderFrame() const { return _renderFrame; }
     bool resetIMU();
+
+    /**
+     * Switches to another preset. The preset is applied at the start of the
+     * next loop, so that all sensors of a frame use the same settings.
+     */
+    void selectPreset(uint8_t index);
+    inline SerialQueue& serialQueue() { return _serialQueue; }
     bool sensorActivity(uint8_t id) const { return _sensors.activity(id); }
     bool sensorAvailable(uint8_t id) const { return _sensors.available(id); }
     int32_t sensorMaxValue(uint8_t id) const { return _sensors.maxValue(id); }
     int32_t sensorMinValue(uint8_t id) const { return _sensors.minValue(id); }
+    int32_t sensorRawValue(uint8_t id) const { return _sensors.rawValue(id); }
+    uint32_t sensorRejected(uint8_t id) const { return _sensors.rejected(id); }
+    bool sensorValid(uint8_t id) const { return _sensors.valid(id); }
     int32_t sensorValue(uint8_t id) const { return _sensors.value(id); }
     void setLED(LED::Mode mode);
     void setDebugSerial(bool enable);
     virtual void setNeoPixel(uint8_t fingerIndex, uint8_t pixelIndex, uint8_t red, uint8_t green, uint8_t blue) {}
+
+    /**
+     * Sets the colors of a whole finger or of all fingers from a NeoPixel
+     * frame. The first byte selects the finger (0 for all), the second the
+     * encoding (NEOPIXEL_FRAME_RAW or NEOPIXEL_FRAME_RLE), followed by the
+     * pixel data. Raw data consists of RGB triples, run-length encoded data
+     * of count/RGB quadruples. Frames with an unknown finger or encoding are
+     * ignored.
+     */
+    void setNeoPixelFrame(const uint8_t* data, uint8_t length);
     void setShowFramerate(bool showFramerate);
     bool showFramerate() const { return _showFramerate; }
 protected:
@@ -129,25 +176,55 @@ protected:
     virtual void doLoop() = 0;
     virtual uint16_t availableButtonMask() const = 0;
     virtual uint16_t availableSensorMask() const = 0;
-    virtual uint16_t readButtonState() const = 0;
+    virtual uint16_t readButtonState() = 0;
+
+    /**
+     * Queues the reads of all device specific inputs of a loop, see I2CQueue.
+     */
+    virtual void requestInputs() = 0;
     virtual void setInfoLED(bool on) = 0;
-    void configureSensor(uint8_t index, double min, double max, double minStdDev);
+
+    /**
+     * Transmits pending NeoPixel changes. Returns true if any strip has been
+     * updated.
+     */
+    virtual bool showNeoPixels() { return false; }
+
+    /**
+     * Sets the default raw range of a sensor, a stored calibration replaces
+     * it. With limitCalibration, the calibration is clamped to the default
+     * range, for sensors whose range depends on a setting.
+     */
+    void configureSensor(uint8_t index, int32_t min, int32_t max, uint16_t minStdDev,
+                         bool limitCalibration = false);
     Sensors _sensors;
 private:
     SmartDevice(const SmartDevice&);
     SmartDevice& operator=(const SmartDevice&);
+    void applySensorConfig(uint8_t id);
     void waitForFlash();
     BehaviourStack _behaviour;
     Buttons _buttons;
-    SSD1306 _display;
+    Display _display;
     bool _debugSerial;
     Adafruit_BNO055 _imu;
-    imu::Vector<3> _imuAcceleration;
-    sensors_event_t _imuEvent;
+    IMU _imuData;
     bool _imuReady;
     bool _flexReady;
     LED _infoLED;
-    unsigned long _lastMs;
+    unsigned long _lastLoopUs;
+    unsigned long _lastNeoPixelMs;
+    unsigned long _lastRenderMs;
+    unsigned long _nextLoopUs;
+    uint8_t _nextPreset;
+    LoopProfiler _profiler;
+    bool _renderFrame;
+    uint16_t _sensorConfigured;
+    uint16_t _sensorLimited;
+    int32_t _sensorMax[SENSOR_COUNT];
+    int32_t _sensorMin[SENSOR_COUNT];
+    uint16_t _sensorMinStdDev[SENSOR_COUNT];
+    SerialQueue _serialQueue;
     bool _showFramerate;
 };
 
@@ -17,6 +17,7 @@
 
 #include "smart_glove.h"
 #include "config.h"
+#include "storage.h"
 
 const uint8_t BUTTON_COUNT = 8;
 const uint8_t BUTTON_MAP[BUTTON_COUNT] = {
@@ -30,15 +31,47 @@ const uint8_t BUTTON_MAP[BUTTON_COUNT] = {
     BUTTON_THUMB_1
 };
 
+struct DistanceProfile {
+    VL53L1X::DistanceMode mode;
+    uint32_t budgetUs;
+    uint32_t periodMs;
+    // range of SENSOR_DISTANCE in mm
+    int32_t maxMM;
+    // measure DISTANCE_ZONES in turn
+    bool zones;
+};
+
+// indexed by DISTANCE_PROFILE_SHORT, DISTANCE_PROFILE_LONG and
+// DISTANCE_PROFILE_ZONES
+const DistanceProfile DISTANCE_PROFILES[DISTANCE_PROFILE_COUNT] = {
+    // hand proximity gestures at 50 Hz
+    { VL53L1X::Short, 20000, 20, 1000, false },
+    // stage distance at 20 Hz
+    { VL53L1X::Long, 50000, 50, 2000, false },
+    // hand movements across the sensor, 50 Hz for all zones together
+    { VL53L1X::Short, 20000, 20, 1000, true }
+};
+
+// three stripes of 6 x 16 SPADs across the array, the centre zone is centred
+// like the full array
+const VL53L1XZone DISTANCE_ZONES[SENSOR_DISTANCE_ZONE_COUNT] = {
+    { 3, 7, 6, 16 },
+    { 8, 7, 6, 16 },
+    { 13, 7, 6, 16 }
+};
+
 SmartGlove::SmartGlove() :
     _ads(false),
     _commandMenu(false),
+    _commandNextPreset(false),
     _distance(I2C_DISTANCE_ADDRESS),
+    _distanceProfile(DISTANCE_PROFILE_LONG),
     _indexFinger(INDEX_FINGER_FLEX_PIN, INDEX_FINGER_NEOPIXEL_PIN),
     _middleFinger(MIDDLE_FINGER_FLEX_PIN, MIDDLE_FINGER_NEOPIXEL_PIN),
     _ringFinger(RING_FINGER_FLEX_PIN, RING_FINGER_NEOPIXEL_PIN),
     _littleFinger(LITTLE_FINGER_FLEX_PIN, LITTLE_FINGER_NEOPIXEL_PIN),
     _menuTimeoutMs(0),
+    _presetTimeoutMs(0),
     _sideButtons(I2C_SMART_GLOVE_SIDE_BUTTONS_ADDRESS),
     _tipButtons(I2C_SMART_GLOVE_TIP_BUTTONS_ADDRESS) {
 }
@@ -59,6 +92,10 @@ bool SmartGlove::commandMenu() const {
     return _commandMenu;
 }
 
+bool SmartGlove::commandNextPreset() const {
+    return _commandNextPreset;
+}
+
 bool SmartGlove::commandUp() const {
     return buttonDown(BUTTON_THUMB_4);
 }
@@ -85,10 +122,11 @@ void SmartGlove::setNeoPixel(uint8_t fingerIndex, uint8_t pixelIndex, uint8_t re
 }
 
 void SmartGlove::doSetup() {
-    configureSensor(SENSOR_FLEX_INDEX_FINGER, 0, 500, 2.0);
-    configureSensor(SENSOR_FLEX_MIDDLE_FINGER, 0, 500, 2.0);
-    configureSensor(SENSOR_FLEX_RING_FINGER, 0, 500, 2.0);
-    configureSensor(SENSOR_FLEX_LITTLE_FINGER, 0, 500, 2.0);
+    // ranges in ADC counts
+    configureSensor(SENSOR_FLEX_INDEX_FINGER, 0, 500, 2);
+    configureSensor(SENSOR_FLEX_MIDDLE_FINGER, 0, 500, 2);
+    configureSensor(SENSOR_FLEX_RING_FINGER, 0, 500, 2);
+    configureSensor(SENSOR_FLEX_LITTLE_FINGER, 0, 500, 2);
 
     _sideButtons.writeConfig(0xF0);
     _sideButtons.writePolarity(0xF0);
@@ -98,20 +136,53 @@ void SmartGlove::doSetup() {
     _middleFinger.init();
     _ringFinger.init();
     _littleFinger.init();
-    _distance.init();
+    applyDistanceProfile(true);
+    _distance.setInterruptPin(DISTANCE_INTERRUPT_PIN);
 }
 
 void SmartGlove::doLoop() {
     unsigned long now = millis();
     _commandMenu = false;
+    _commandNextPreset = false;
 
     _sensors.addMeasurement(now, SENSOR_FLEX_INDEX_FINGER, _indexFinger.readFlex());
     _sensors.addMeasurement(now, SENSOR_FLEX_MIDDLE_FINGER, _middleFinger.readFlex());
     _sensors.addMeasurement(now, SENSOR_FLEX_RING_FINGER, _ringFinger.readFlex());
     _sensors.addMeasurement(now, SENSOR_FLEX_LITTLE_FINGER, _littleFinger.readFlex());
 
-    if (_distance.dataReady()) {
-        _sensors.addMeasurement(now, SENSOR_DISTANCE, _distance.readInput());
+    if (Storage.distanceProfile() != _distanceProfile) {
+        // no distance transactions are queued at this point
+        applyDistanceProfile(false);
+    }
+
+    if (_distance.sampleReady()) {
+        // time of acquisition, up to a measurement period before now
+        unsigned long sampleMs = _distance.sampleMs();
+        bool valid = _distance.sampleValid();
+        int32_t distance = _distance.takeSample();
+        if (_distance.zoneCount() > 0) {
+            // the distance is the nearest of the latest zone samples, failed
+            // ones have been replaced by the sensors, it is valid if the
+            // nearest zone has been measured
+            uint8_t zone = _distance.sampleZone();
+            _sensors.addMeasurement(sampleMs, SENSOR_DISTANCE_ZONE_1 + zone, distance, valid);
+            _zoneMM[zone] = _sensors.rawValue(SENSOR_DISTANCE_ZONE_1 + zone);
+            uint8_t nearest = 0;
+            for (uint8_t i = 1; i < SENSOR_DISTANCE_ZONE_COUNT; ++i) {
+                if (_zoneMM[i] < _zoneMM[nearest]) {
+                    nearest = i;
+                }
+            }
+
+            distance = _zoneMM[nearest];
+            valid = _sensors.valid(SENSOR_DISTANCE_ZONE_1 + nearest);
+        }
+
+        _sensors.addMeasurement(sampleMs, SENSOR_DISTANCE, distance, valid);
+        if (_distance.calibrated()) {
+            // only written if it has been measured anew
+            Storage.setDistanceCalibration(_distance.calibration());
+        }
     }
 
     if (buttonCombination(BUTTON_THUMB_1, BUTTON_THUMB_2)) {
@@ -127,6 +198,17 @@ void SmartGlove::doLoop() {
     else {
         _menuTimeoutMs = now + LONG_PRESS_MS;
     }
+
+    // both buttons are streamed to the host, only a long press switches
+    if (buttonPressed(BUTTON_THUMB_2) && buttonPressed(BUTTON_LITTLE_FINGER_1)) {
+        if (_presetTimeoutMs < now) {
+            _commandNextPreset = true;
+            _presetTimeoutMs = now + LONG_PRESS_MS;
+        }
+    }
+    else {
+        _presetTimeoutMs = now + LONG_PRESS_MS;
+    }
 }
 
 uint16_t SmartGlove::availableButtonMask() const {
@@ -142,7 +224,13 @@ uint16_t SmartGlove::availableButtonMask() const {
 }
 
 uint16_t SmartGlove::availableSensorMask() const {
+    uint16_t zones = 0;
+    if (DISTANCE_PROFILES[_distanceProfile].zones) {
+        zones = (1 << SENSOR_DISTANCE_ZONE_1) | (1 << SENSOR_DISTANCE_ZONE_2) | (1 << SENSOR_DISTANCE_ZONE_3);
+    }
+
     return
+        zones |
         (1 << SENSOR_ACCEL_X) |
         (1 << SENSOR_ACCEL_Y) |
         (1 << SENSOR_ACCEL_Z) |
@@ -156,19 +244,63 @@ uint16_t SmartGlove::availableSensorMask() const {
         (1 << SENSOR_FLEX_LITTLE_FINGER);
 }
 
-uint16_t SmartGlove::readButtonState() const {
+uint16_t SmartGlove::readButtonState() {
     uint16_t result = 0;
-    uint8_t buttons = (_sideButtons.readInput() & 0xF0) | ((_tipButtons.readInput() & 0xF0) >> 4);
+    uint8_t buttons = (_sideButtons.input() & 0xF0) | ((_tipButtons.input() & 0xF0) >> 4);
     for (uint8_t bit = 0; bit < BUTTON_COUNT; ++bit) {
         if (buttons & (1 << bit)) {
             result |= (1 << BUTTON_MAP[bit]);
         }
     }
 
-    _sideButtons.writeOutput(~(buttons >> 4));
-    _tipButtons.writeOutput(~(buttons & 0x0F));
+    _sideButtons.queueOutput(~(buttons >> 4));
+    _tipButtons.queueOutput(~(buttons & 0x0F));
     return result;
 }
 
+void SmartGlove::requestInputs() {
+    _sideButtons.requestInput();
+    _tipButtons.requestInput();
+    _distance.requestSample();
+}
+
+void SmartGlove::applyDistanceProfile(bool init) {
+    _distanceProfile = Storage.distanceProfile();
+    const DistanceProfile& profile = DISTANCE_PROFILES[_distanceProfile];
+    // a calibration is limited to the range of the profile
+    configureSensor(SENSOR_DISTANCE, 0, profile.maxMM, 2, true);
+    _sensors.configureInvalid(SENSOR_DISTANCE, DISTANCE_HOLD_MS, DISTANCE_DECAY_MS);
+    for (uint8_t i = 0; i < SENSOR_DISTANCE_ZONE_COUNT; ++i) {
+        configureSensor(SENSOR_DISTANCE_ZONE_1 + i, 0, profile.maxMM, 2, true);
+        _sensors.configureInvalid(SENSOR_DISTANCE_ZONE_1 + i, DISTANCE_HOLD_MS, DISTANCE_DECAY_MS);
+        _zoneMM[i] = profile.maxMM;
+    }
+
+    _sensors.setAvailable(availableSensorMask());
+    if (init) {
+        _distance.setCalibration(Storage.distanceCalibration());
+        _distance.init(profile.mode, profile.budgetUs, profile.periodMs);
+    }
+    else {
+        _distance.setRanging(profile.mode, profile.budgetUs, profile.periodMs);
+    }
+
+    if (profile.zones) {
+        _distance.setZones(DISTANCE_ZONES, SENSOR_DISTANCE_ZONE_COUNT);
+    }
+    else if (_distance.zoneCount() > 0) {
+        _distance.setZones(NULL, 0);
+    }
+}
+
 void SmartGlove::setInfoLED(bool on) {
 }
+
+bool SmartGlove::showNeoPixels() {
+    // all strips are updated in the same loop
+    bool result = _indexFinger.showNeoPixels();
+    result = _middleFinger.showNeoPixels() || result;
+    result = _ringFinger.showNeoPixels() || result;
+    result = _littleFinger.showNeoPixels() || result;
+    return result;
+}
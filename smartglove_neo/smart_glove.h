@@ -30,6 +30,7 @@ public:
     virtual bool commandDown() const;
     virtual bool commandEnter() const;
     virtual bool commandMenu() const;
+    virtual bool commandNextPreset() const;
     virtual bool commandUp() const;
     virtual bool flexReady() const;
     virtual void setNeoPixel(uint8_t fingerIndex, uint8_t pixelIndex, uint8_t red, uint8_t green, uint8_t blue);
@@ -38,19 +39,26 @@ protected:
     virtual void doLoop();
     virtual uint16_t availableButtonMask() const;
     virtual uint16_t availableSensorMask() const;
-    virtual uint16_t readButtonState() const;
+    virtual uint16_t readButtonState();
+    virtual void requestInputs();
     virtual void setInfoLED(bool on);
+    virtual bool showNeoPixels();
 private:
+    void applyDistanceProfile(bool init);
     bool _ads;
     bool _commandMenu;
+    bool _commandNextPreset;
     VL53L1X _distance;
+    uint8_t _distanceProfile;
     Finger _indexFinger;
     Finger _middleFinger;
     Finger _ringFinger;
     Finger _littleFinger;
     unsigned long _menuTimeoutMs;
+    unsigned long _presetTimeoutMs;
     PCA9557 _sideButtons;
     PCA9557 _tipButtons;
+    int32_t _zoneMM[SENSOR_DISTANCE_ZONE_COUNT];
 };
 
 #endif
@@ -17,6 +17,9 @@
 
 #include "storage.h"
 #include <Wire.h>
+#include "config.h"
+#include "i2c_master.h"
+#include "i2c_queue.h"
 
 #define NO_EEPROM
 
@@ -26,38 +29,492 @@
 #include <EEPROM.h>
 #endif
 
-StorageSingleton::StorageSingleton() {
+#define EEPROM_PAGE_SIZE 32
+// the Wire buffer also holds the two address bytes
+#define EEPROM_WRITE_SIZE 16
+#define EEPROM_WRITE_CYCLE_TIMEOUT_MS 20
+
+#define STATE_IDLE    0
+#define STATE_WRITING 1
+#define STATE_WAITING 2
+#define STATE_RETRY   3
+// a write or poll is queued, see I2CQueue
+#define STATE_QUEUED  4
+
+#define RETRY_INTERVAL_MS 100
+
+// record layout: version, payload size, sequence, payload, CRC
+#define RECORD_VERSION 2
+#define RECORD_HEADER_SIZE 4
+#define RECORD_OVERHEAD 6
+#define READ_CHUNK_SIZE 32
+
+// fixed addresses used before the records, in the first settings slot
+#define LEGACY_BOARD_ID 2
+#define LEGACY_SHOW_FRAMERATE 3
+#define LEGACY_PROTOCOL 4
+#define LEGACY_SIZE 5
+
+static uint16_t crc16(const uint8_t* data, uint8_t length) {
+    // CRC-16/CCITT-FALSE
+    uint16_t crc = 0xFFFF;
+    for (uint8_t i = 0; i < length; ++i) {
+        crc ^= static_cast<uint16_t>(data[i]) << 8;
+        for (uint8_t bit = 0; bit < 8; ++bit) {
+            if (crc & 0x8000) {
+                crc = (crc << 1) ^ 0x1021;
+            }
+            else {
+                crc = crc << 1;
+            }
+        }
+    }
+
+    return crc;
+}
+
+static int16_t clampInt16(int32_t value) {
+    if (value < INT16_MIN) {
+        return INT16_MIN;
+    }
+
+    if (value > INT16_MAX) {
+        return INT16_MAX;
+    }
+
+    return value;
+}
+
+StorageSingleton::StorageSingleton() :
+    _readAddress(0),
+    _stateMs(0),
+    _state(STATE_IDLE),
+    _writeAddress(0),
+    _writeChunk(0),
+    _writeLength(0),
+    _writeOffset(0),
+    _writeRegion(0) {
+    _settings.boardId = '1';
+    _settings.distanceProfile = DISTANCE_PROFILE_LONG;
+    _settings.preset = 0;
+    _settings.showFramerate = 0;
+    // slot sizes are a multiple or a fraction of the EEPROM page size
+    initRegion(STORAGE_REGION_SETTINGS, 0x0000, 16, 16, &_settings, sizeof(_settings));
+    for (uint8_t i = 0; i < STORAGE_PRESET_COUNT; ++i) {
+        StoragePreset& preset = _presets[i];
+        memset(&preset, 0, sizeof(preset));
+        preset.protocol = PROTOCOL_JUNXION;
+        preset.activityScale = 100;
+        preset.gestureTimeoutMs = GESTURE_TIMEOUT_MS;
+        initRegion(STORAGE_REGION_PRESET + i, 0x0100 + i * 0x0100, 64, 4, &preset, sizeof(preset));
+    }
+
+    memset(&_distanceCalibration, 0, sizeof(_distanceCalibration));
+    initRegion(STORAGE_REGION_DISTANCE, 0x0500, 16, 4, &_distanceCalibration, sizeof(_distanceCalibration));
+}
+
+void StorageSingleton::begin() {
+    bool loaded[STORAGE_REGION_COUNT];
+    for (uint8_t i = 0; i < STORAGE_REGION_COUNT; ++i) {
+        loaded[i] = load(_regions[i]);
+    }
+
+    // migrated after all regions, so that no record overwrites the settings
+    // taken over
+    if (!loaded[STORAGE_REGION_SETTINGS]) {
+        loadLegacy(!loaded[STORAGE_REGION_PRESET]);
+    }
+
+    if (_settings.preset >= STORAGE_PRESET_COUNT) {
+        _settings.preset = 0;
+    }
+
+    if (_settings.distanceProfile >= DISTANCE_PROFILE_COUNT) {
+        _settings.distanceProfile = DISTANCE_PROFILE_LONG;
+    }
+}
+
+void StorageSingleton::loop() {
+    unsigned long now = millis();
+    switch (_state) {
+    case STATE_IDLE:
+        for (uint8_t i = 0; i < STORAGE_REGION_COUNT; ++i) {
+            if (_regions[i].dirty) {
+                startCommit(i);
+                break;
+            }
+        }
+
+        break;
+    case STATE_WRITING: {
+        // write up to the end of the page
+        uint16_t address = _writeAddress + _writeOffset;
+        uint8_t length = _writeLength - _writeOffset;
+        uint8_t pageRest = EEPROM_PAGE_SIZE - address % EEPROM_PAGE_SIZE;
+        if (length > pageRest) {
+            length = pageRest;
+        }
+
+        if (length > EEPROM_WRITE_SIZE) {
+            length = EEPROM_WRITE_SIZE;
+        }
+
+        _stateMs = now;
+        _writeChunk = length;
+        _state = STATE_QUEUED;
+        write(address, _buffer + _writeOffset, length);
+        break;
+    }
+    case STATE_WAITING:
+        // the EEPROM doesn't acknowledge its address during the write cycle
+        if (now - _stateMs < EEPROM_WRITE_CYCLE_TIMEOUT_MS) {
+            _state = STATE_QUEUED;
+            poll();
+        }
+        else {
+            writeCycleDone();
+        }
+
+        break;
+    case STATE_RETRY:
+        if (now - _stateMs >= RETRY_INTERVAL_MS) {
+            _state = STATE_WRITING;
+        }
+
+        break;
+    }
 }
 
-void StorageSingleton::writeByte(uint16_t address, uint8_t data) const {
+void StorageSingleton::setActivityScale(uint8_t value) {
+    if (_presets[_settings.preset].activityScale != value) {
+        _presets[_settings.preset].activityScale = value;
+        presetChanged();
+    }
+}
+
+bool StorageSingleton::calibrated(uint8_t sensorId) const {
+    sensorId = calibrationIndex(sensorId);
+    return sensorId < STORAGE_CALIBRATION_COUNT && (_presets[_settings.preset].calibration.mask & (1 << sensorId));
+}
+
+int16_t StorageSingleton::calibrationMax(uint8_t sensorId) const {
+    sensorId = calibrationIndex(sensorId);
+    return sensorId < STORAGE_CALIBRATION_COUNT ? _presets[_settings.preset].calibration.max[sensorId] : 0;
+}
+
+int16_t StorageSingleton::calibrationMin(uint8_t sensorId) const {
+    sensorId = calibrationIndex(sensorId);
+    return sensorId < STORAGE_CALIBRATION_COUNT ? _presets[_settings.preset].calibration.min[sensorId] : 0;
+}
+
+void StorageSingleton::setCalibration(uint8_t sensorId, int32_t rawMin, int32_t rawMax) {
+    // the preset slot is full, the fields can't be widened
+    int16_t min = clampInt16(rawMin);
+    int16_t max = clampInt16(rawMax);
+    if (sensorId >= STORAGE_CALIBRATION_COUNT || min == max) {
+        return;
+    }
+
+    StorageCalibration& calibration = _presets[_settings.preset].calibration;
+    if (calibrated(sensorId) && calibration.min[sensorId] == min && calibration.max[sensorId] == max) {
+        return;
+    }
+
+    calibration.mask |= 1 << sensorId;
+    calibration.max[sensorId] = max;
+    calibration.min[sensorId] = min;
+    presetChanged();
+}
+
+bool StorageSingleton::dirty() const {
+    for (uint8_t i = 0; i < STORAGE_REGION_COUNT; ++i) {
+        if (_regions[i].dirty) {
+            return true;
+        }
+    }
+
+    return _state != STATE_IDLE;
+}
+
+void StorageSingleton::setBoardId(uint8_t value) {
+    if (_settings.boardId != value) {
+        _settings.boardId = value;
+        _regions[STORAGE_REGION_SETTINGS].dirty = true;
+    }
+}
+
+void StorageSingleton::setDistanceCalibration(const VL53L1XCalibration& value) {
+    if (memcmp(&_distanceCalibration, &value, sizeof(value)) != 0) {
+        _distanceCalibration = value;
+        _regions[STORAGE_REGION_DISTANCE].dirty = true;
+    }
+}
+
+void StorageSingleton::setDistanceProfile(uint8_t value) {
+    if (_settings.distanceProfile != value) {
+        _settings.distanceProfile = value;
+        _regions[STORAGE_REGION_SETTINGS].dirty = true;
+    }
+}
+
+void StorageSingleton::setGestureTimeoutMs(uint16_t value) {
+    if (_presets[_settings.preset].gestureTimeoutMs != value) {
+        _presets[_settings.preset].gestureTimeoutMs = value;
+        presetChanged();
+    }
+}
+
+void StorageSingleton::setPreset(uint8_t index) {
+    if (index < STORAGE_PRESET_COUNT && _settings.preset != index) {
+        _settings.preset = index;
+        _regions[STORAGE_REGION_SETTINGS].dirty = true;
+    }
+}
+
+void StorageSingleton::presetName(uint8_t index, char* name) const {
+    if (index < STORAGE_PRESET_COUNT) {
+        sprintf(name, "Piece %u", index + 1);
+    }
+    else {
+        name[0] = '\0';
+    }
+}
+
+void StorageSingleton::setProtocol(uint8_t value) {
+    if (_presets[_settings.preset].protocol != value) {
+        _presets[_settings.preset].protocol = value;
+        presetChanged();
+    }
+}
+
+void StorageSingleton::setShowFramerate(uint8_t value) {
+    if (_settings.showFramerate != value) {
+        _settings.showFramerate = value;
+        _regions[STORAGE_REGION_SETTINGS].dirty = true;
+    }
+}
+
+void StorageSingleton::beginRead(uint16_t address) {
+    _readAddress = address;
 #if defined(NO_EEPROM)
+    // the bus is shared with the queued transfers
+    I2CMaster.wait();
     Wire.beginTransmission(EEPROM_ADDRESS);
     Wire.write(static_cast<uint8_t>(address >> 8));
     Wire.write(static_cast<uint8_t>(address & 0xFF));
-    Wire.write(data);
     Wire.endTransmission();
-    delay(5); // minimum delay required by 24AA64 EEPROM
-#else
-    EEPROM.update(address, data);
 #endif
 }
 
-uint8_t StorageSingleton::readByte(uint16_t address) const {
+uint8_t StorageSingleton::calibrationIndex(uint8_t sensorId) {
+    if (sensorId >= SENSOR_DISTANCE_ZONE_1 && sensorId < SENSOR_DISTANCE_ZONE_1 + SENSOR_DISTANCE_ZONE_COUNT) {
+        return SENSOR_DISTANCE;
+    }
+
+    return sensorId;
+}
+
+void StorageSingleton::initRegion(uint8_t index, uint16_t base, uint8_t slotSize, uint8_t slotCount,
+                                  void* data, uint8_t size) {
+    StorageRegion& region = _regions[index];
+    region.base = base;
+    region.slotSize = slotSize;
+    region.slotCount = slotCount;
+    region.data = static_cast<uint8_t*>(data);
+    region.size = size;
+    // the first commit goes to slot 0
+    region.slot = slotCount - 1;
+    region.sequence = 0;
+    region.dirty = false;
+}
+
+bool StorageSingleton::load(StorageRegion& region) {
+    // one sequential read over all slots of the region
+    beginRead(region.base);
+    bool found = false;
+    for (uint8_t slot = 0; slot < region.slotCount; ++slot) {
+        readNext(_buffer, region.slotSize);
+        // records of older versions may be shorter, see StorageSettings
+        uint8_t size = _buffer[1];
+        uint8_t recordSize = size + RECORD_OVERHEAD;
+        if (_buffer[0] != RECORD_VERSION || size > region.size || recordSize > region.slotSize) {
+            continue;
+        }
+
+        uint16_t crc = _buffer[recordSize - 2] | (_buffer[recordSize - 1] << 8);
+        if (crc16(_buffer, recordSize - 2) != crc) {
+            continue;
+        }
+
+        uint16_t sequence = _buffer[2] | (_buffer[3] << 8);
+        if (!found || static_cast<int16_t>(sequence - region.sequence) > 0) {
+            memcpy(region.data, _buffer + RECORD_HEADER_SIZE, size);
+            region.sequence = sequence;
+            region.slot = slot;
+            found = true;
+        }
+    }
+
+    return found;
+}
+
+void StorageSingleton::loadLegacy(bool migrateProtocol) {
+    uint8_t legacy[LEGACY_SIZE];
+    beginRead(0);
+    readNext(legacy, LEGACY_SIZE);
+    // erased bytes are 0xFF, each setting is taken over if it is valid
+    bool found = false;
+    uint8_t boardId = legacy[LEGACY_BOARD_ID];
+    if (boardId >= '1' && boardId <= '4') {
+        _settings.boardId = boardId;
+        found = true;
+    }
+
+    if (legacy[LEGACY_SHOW_FRAMERATE] <= 1) {
+        _settings.showFramerate = legacy[LEGACY_SHOW_FRAMERATE];
+        found = true;
+    }
+
+    if (migrateProtocol && legacy[LEGACY_PROTOCOL] <= PROTOCOL_MAX) {
+        // the protocol has been global, it goes to the first preset unless
+        // that one has a record
+        _presets[0].protocol = legacy[LEGACY_PROTOCOL];
+        _regions[STORAGE_REGION_PRESET].dirty = true;
+        found = true;
+    }
+
+    if (found) {
+        // the first record replaces the fixed addresses
+        _regions[STORAGE_REGION_SETTINGS].dirty = true;
+    }
+}
+
+void StorageSingleton::poll() {
 #if defined(NO_EEPROM)
-    Wire.beginTransmission(EEPROM_ADDRESS);
-    Wire.write(static_cast<uint8_t>(address >> 8));
-    Wire.write(static_cast<uint8_t>(address & 0xFF));
-    Wire.endTransmission();
-    Wire.requestFrom(EEPROM_ADDRESS, static_cast<uint8_t>(1));
-    if (Wire.available()) {
-        return Wire.read();
+    // sets the address pointer only, the EEPROM doesn't mind
+    I2CTransaction transaction;
+    transaction.address = EEPROM_ADDRESS;
+    transaction.callback = polled;
+    transaction.context = this;
+    transaction.data = NULL;
+    transaction.length = 0;
+    transaction.priority = I2C_PRIORITY_LOW;
+    transaction.read = false;
+    transaction.reg = _writeAddress;
+    transaction.regSize = 2;
+    if (!I2CQueue.submit(transaction)) {
+        _state = STATE_WAITING;
+    }
+#else
+    polled(this, true);
+#endif
+}
+
+void StorageSingleton::polled(void* context, bool success) {
+    StorageSingleton* self = static_cast<StorageSingleton*>(context);
+    if (success) {
+        self->writeCycleDone();
     }
     else {
-        return 0;
+        self->_state = STATE_WAITING;
+    }
+}
+
+void StorageSingleton::presetChanged() {
+    _regions[STORAGE_REGION_PRESET + _settings.preset].dirty = true;
+}
+
+void StorageSingleton::readNext(uint8_t* data, uint8_t length) {
+    memset(data, 0, length);
+#if defined(NO_EEPROM)
+    // current address reads continue where the previous read stopped
+    uint8_t pos = 0;
+    while (pos < length) {
+        uint8_t chunk = length - pos < READ_CHUNK_SIZE ? length - pos : READ_CHUNK_SIZE;
+        Wire.requestFrom(EEPROM_ADDRESS, chunk);
+        for (uint8_t i = 0; i < chunk && Wire.available(); ++i) {
+            data[pos + i] = Wire.read();
+        }
+
+        pos += chunk;
+    }
+#else
+    for (uint8_t i = 0; i < length; ++i) {
+        data[i] = EEPROM.load(_readAddress + i);
+    }
+#endif
+    _readAddress += length;
+}
+
+void StorageSingleton::startCommit(uint8_t index) {
+    // the record is built from a snapshot, later changes cause another commit
+    StorageRegion& region = _regions[index];
+    uint16_t sequence = region.sequence + 1;
+    uint8_t recordSize = region.size + RECORD_OVERHEAD;
+    _buffer[0] = RECORD_VERSION;
+    _buffer[1] = region.size;
+    _buffer[2] = sequence & 0xFF;
+    _buffer[3] = sequence >> 8;
+    memcpy(_buffer + RECORD_HEADER_SIZE, region.data, region.size);
+    uint16_t crc = crc16(_buffer, recordSize - 2);
+    _buffer[recordSize - 2] = crc & 0xFF;
+    _buffer[recordSize - 1] = crc >> 8;
+    region.dirty = false;
+    _writeAddress = region.base + ((region.slot + 1) % region.slotCount) * region.slotSize;
+    _writeLength = recordSize;
+    _writeOffset = 0;
+    _writeRegion = index;
+    _state = STATE_WRITING;
+}
+
+void StorageSingleton::write(uint16_t address, uint8_t* data, uint8_t length) {
+#if defined(NO_EEPROM)
+    // page write, must not cross a page boundary
+    I2CTransaction transaction;
+    transaction.address = EEPROM_ADDRESS;
+    transaction.callback = written;
+    transaction.context = this;
+    transaction.data = data;
+    transaction.length = length;
+    transaction.priority = I2C_PRIORITY_LOW;
+    transaction.read = false;
+    transaction.reg = address;
+    transaction.regSize = 2;
+    if (!I2CQueue.submit(transaction)) {
+        _state = STATE_RETRY;
     }
 #else
-    return EEPROM.load(address);
+    for (uint8_t i = 0; i < length; ++i) {
+        EEPROM.update(address + i, data[i]);
+    }
+
+    written(this, true);
 #endif
 }
 
+void StorageSingleton::writeCycleDone() {
+    if (_writeOffset < _writeLength) {
+        _state = STATE_WRITING;
+    }
+    else {
+        StorageRegion& region = _regions[_writeRegion];
+        region.slot = (region.slot + 1) % region.slotCount;
+        ++region.sequence;
+        _state = STATE_IDLE;
+    }
+}
+
+void StorageSingleton::written(void* context, bool success) {
+    StorageSingleton* self = static_cast<StorageSingleton*>(context);
+    // the write cycle starts when the transfer has completed
+    self->_stateMs = millis();
+    if (success) {
+        self->_writeOffset += self->_writeChunk;
+        self->_state = STATE_WAITING;
+    }
+    else {
+        self->_state = STATE_RETRY;
+    }
+}
+
 StorageSingleton Storage;
@@ -19,26 +19,177 @@
 #define STORAGE_H
 
 #include <Arduino.h>
+#include "sensors.h"
+#include "vl53l1x.h"
 
-#define STORAGE_BOARD_ID 2
-#define STORAGE_SHOW_FRAMERATE 3
-#define STORAGE_PROTOCOL 4
+#define PROTOCOL_JUNXION 0
+#define PROTOCOL_MAX 1
 
+// ranging profiles of the distance sensor
+#define DISTANCE_PROFILE_SHORT 0
+#define DISTANCE_PROFILE_LONG 1
+#define DISTANCE_PROFILE_ZONES 2
+#define DISTANCE_PROFILE_COUNT 3
+
+#define STORAGE_PRESET_COUNT 4
+// size of a preset label including the terminating zero, see presetName()
+#define STORAGE_PRESET_NAME_SIZE 8
+
+#define STORAGE_REGION_SETTINGS 0
+#define STORAGE_REGION_PRESET 1
+#define STORAGE_REGION_DISTANCE (STORAGE_REGION_PRESET + STORAGE_PRESET_COUNT)
+#define STORAGE_REGION_COUNT (STORAGE_REGION_DISTANCE + 1)
+// largest slot, holds a record including header and checksum
+#define STORAGE_MAX_RECORD_SIZE 64
+
+/**
+ * New fields are only appended, records written by older versions are read
+ * and keep the defaults of the missing fields.
+ */
+struct StorageSettings {
+    uint8_t boardId;
+    uint8_t preset;
+    uint8_t showFramerate;
+    uint8_t distanceProfile;
+};
+
+// the distance zones share the calibration of SENSOR_DISTANCE
+#define STORAGE_CALIBRATION_COUNT SENSOR_DISTANCE_ZONE_1
+
+/**
+ * Calibrated raw range of each sensor. Only sensors with their bit set in
+ * mask have been calibrated.
+ */
+struct StorageCalibration {
+    uint16_t mask;
+    int16_t max[STORAGE_CALIBRATION_COUNT];
+    int16_t min[STORAGE_CALIBRATION_COUNT];
+};
+
+/**
+ * Everything that differs between pieces. activityScale scales the default
+ * activity thresholds of all sensors in percent.
+ */
+struct StoragePreset {
+    uint8_t protocol;
+    uint8_t activityScale;
+    uint16_t gestureTimeoutMs;
+    StorageCalibration calibration;
+};
+
+/**
+ * A block of data that is stored as a versioned record with checksum. Each
+ * region of the EEPROM holds a ring of slots, every commit writes the next
+ * slot, so that writes are spread over the region.
+ */
+struct StorageRegion {
+    uint16_t base;
+    uint8_t slotSize;
+    uint8_t slotCount;
+    uint8_t* data;
+    uint8_t size;
+    uint8_t slot;
+    uint16_t sequence;
+    bool dirty;
+};
+
+/**
+ * Settings stored in the EEPROM. All settings are read once in begin() and
+ * kept in RAM. Changes are committed to the EEPROM in the background by
+ * loop(), without waiting for the write cycle of the EEPROM.
+ */
 class StorageSingleton {
 public:
     StorageSingleton();
-    inline uint8_t boardId() const { return readByte(STORAGE_BOARD_ID); };
-    void setBoardId(uint8_t value) { writeByte(STORAGE_BOARD_ID, value); }
-    inline uint8_t protocol() const { return readByte(STORAGE_PROTOCOL); };
-    void setProtocol(uint8_t value) { writeByte(STORAGE_PROTOCOL, value); }
-    inline uint8_t showFramerate() const { return readByte(STORAGE_SHOW_FRAMERATE); };
-    void setShowFramerate(uint8_t value) { writeByte(STORAGE_SHOW_FRAMERATE, value); }
+
+    /**
+     * Loads the newest valid record of each region from the EEPROM. Regions
+     * without a valid record keep their default values. Without a settings
+     * record, the board id, framerate display and protocol are taken from
+     * the fixed addresses of earlier firmware versions. The I2C bus must
+     * have been initialized before.
+     */
+    void begin();
+
+    /**
+     * Writes changed settings to the EEPROM, the transfers are queued with
+     * low priority, see I2CQueue. Must be called regularly.
+     */
+    void loop();
+    inline uint8_t activityScale() const { return _presets[_settings.preset].activityScale; }
+    void setActivityScale(uint8_t value);
+    inline uint8_t boardId() const { return _settings.boardId; };
+    void setBoardId(uint8_t value);
+
+    /**
+     * The calibration, gesture timeout, activity scale and protocol always
+     * refer to the active preset. Calibrated ranges are stored as 16 bit
+     * values, setCalibration() clamps them and ignores a range that is
+     * empty after clamping.
+     */
+    bool calibrated(uint8_t sensorId) const;
+    int16_t calibrationMax(uint8_t sensorId) const;
+    int16_t calibrationMin(uint8_t sensorId) const;
+    void setCalibration(uint8_t sensorId, int32_t min, int32_t max);
+
+    /**
+     * Returns true if changed settings have not been completely written to
+     * the EEPROM yet.
+     */
+    bool dirty() const;
+
+    /**
+     * Calibration of the distance sensor from an earlier start, all zero if
+     * there is none. It belongs to the sensor, not to a preset.
+     */
+    inline const VL53L1XCalibration& distanceCalibration() const { return _distanceCalibration; }
+    void setDistanceCalibration(const VL53L1XCalibration& value);
+    inline uint8_t distanceProfile() const { return _settings.distanceProfile; }
+    void setDistanceProfile(uint8_t value);
+    inline uint16_t gestureTimeoutMs() const { return _presets[_settings.preset].gestureTimeoutMs; }
+    void setGestureTimeoutMs(uint16_t value);
+    inline uint8_t preset() const { return _settings.preset; }
+    void setPreset(uint8_t index);
+
+    /**
+     * Writes the label of a preset ("Piece 1" to "Piece 4") to name, which
+     * must hold STORAGE_PRESET_NAME_SIZE characters.
+     */
+    void presetName(uint8_t index, char* name) const;
+    inline uint8_t protocol() const { return _presets[_settings.preset].protocol; };
+    void setProtocol(uint8_t value);
+    inline uint8_t showFramerate() const { return _settings.showFramerate; };
+    void setShowFramerate(uint8_t value);
 private:
     StorageSingleton(const StorageSingleton&);
     StorageSingleton operator=(const StorageSingleton&);
 
-    void writeByte(uint16_t address, uint8_t data) const;
-    uint8_t readByte(uint16_t address) const;
+    void beginRead(uint16_t address);
+    static uint8_t calibrationIndex(uint8_t sensorId);
+    void initRegion(uint8_t index, uint16_t base, uint8_t slotSize, uint8_t slotCount, void* data, uint8_t size);
+    bool load(StorageRegion& region);
+    void loadLegacy(bool migrateProtocol);
+    void poll();
+    static void polled(void* context, bool success);
+    void readNext(uint8_t* data, uint8_t length);
+    void startCommit(uint8_t index);
+    void write(uint16_t address, uint8_t* data, uint8_t length);
+    void writeCycleDone();
+    static void written(void* context, bool success);
+    void presetChanged();
+    uint8_t _buffer[STORAGE_MAX_RECORD_SIZE];
+    VL53L1XCalibration _distanceCalibration;
+    StoragePreset _presets[STORAGE_PRESET_COUNT];
+    uint16_t _readAddress;
+    StorageRegion _regions[STORAGE_REGION_COUNT];
+    StorageSettings _settings;
+    unsigned long _stateMs;
+    uint8_t _state;
+    uint16_t _writeAddress;
+    uint8_t _writeChunk;
+    uint8_t _writeLength;
+    uint8_t _writeOffset;
+    uint8_t _writeRegion;
 };
 
 extern StorageSingleton Storage;
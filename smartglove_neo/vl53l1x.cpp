@@ -18,6 +18,24 @@
 #include "vl53l1x.h"
 #include <Wire.h>
 
+// polling restarts this long before the next measurement is due, covers the
+// loop interval and the drift of the sensor oscillator
+#define POLL_MARGIN_MS 10
+
+// RESULT__RANGE_STATUS of measurements that are used, all other ones have
+// failed, for example for lack of a target or because the signal rate or the
+// sigma estimate exceeded the limits of the static configuration
+#define RANGE_STATUS_MIN_RANGE_CLIPPED 8
+#define RANGE_STATUS_VALID 9
+// the upper bits of RESULT__RANGE_STATUS are not part of the status
+#define RANGE_STATUS_MASK 0x1F
+
+// the whole SPAD array
+#define FULL_ROI_CENTRE_SPAD 199
+#define FULL_ROI_SIZE 0xFF
+#define MIN_ROI_SIZE 4
+#define MAX_ROI_SIZE 16
+
 enum regAddr : uint16_t {
     SOFT_RESET                                                                 = 0x0000,
     I2C_SLAVE__DEVICE_ADDRESS                                                  = 0x0001,
@@ -61,6 +79,8 @@ enum regAddr : uint16_t {
     SD_CONFIG__INITIAL_PHASE_SD1                                               = 0x007B,
     SYSTEM__GROUPED_PARAMETER_HOLD_1                                           = 0x007C,
     SD_CONFIG__QUANTIFIER                                                      = 0x007E,
+    ROI_CONFIG__USER_ROI_CENTRE_SPAD                                           = 0x007F,
+    ROI_CONFIG__USER_ROI_REQUESTED_GLOBAL_XY_SIZE                              = 0x0080,
     SYSTEM__SEQUENCE_CONFIG                                                    = 0x0081,
     SYSTEM__GROUPED_PARAMETER_HOLD                                             = 0x0082,
     SYSTEM__INTERRUPT_CLEAR                                                    = 0x0086,
@@ -91,6 +111,95 @@ const uint32_t TIMING_GUARD = 4528;
 
 const uint16_t TARGET_RATE = 0x0A00;
 
+/*
+ * static, general, timing and dynamic configuration as written by
+ * VL53L1_set_preset_mode(), in the same order; consecutive registers are
+ * combined into one transaction by writeRegisterList16()
+ * values labeled "tuning parm default" are from vl53l1_tuning_parm_defaults.h
+ */
+const I2CRegisterValue STATIC_CONFIG[] = {
+    // static config
+    // API resets PAD_I2C_HV__EXTSUP_CONFIG here, but maybe we don't want to do
+    // that? (seems like it would disable 2V8 mode)
+    { DSS_CONFIG__TARGET_TOTAL_RATE_MCPS, TARGET_RATE >> 8 }, // should already be this value after reset
+    { DSS_CONFIG__TARGET_TOTAL_RATE_MCPS + 1, TARGET_RATE & 0xFF },
+    { GPIO__TIO_HV_STATUS, 0x02 },
+    { SIGMA_ESTIMATOR__EFFECTIVE_PULSE_WIDTH_NS, 8 }, // tuning parm default
+    { SIGMA_ESTIMATOR__EFFECTIVE_AMBIENT_WIDTH_NS, 16 }, // tuning parm default
+    { ALGO__CROSSTALK_COMPENSATION_VALID_HEIGHT_MM, 0x01 },
+    { ALGO__RANGE_IGNORE_VALID_HEIGHT_MM, 0xFF },
+    { ALGO__RANGE_MIN_CLIP, 0 }, // tuning parm default
+    { ALGO__CONSISTENCY_CHECK__TOLERANCE, 2 }, // tuning parm default
+    // general config
+    { SYSTEM__THRESH_RATE_HIGH, 0x00 },
+    { SYSTEM__THRESH_RATE_HIGH + 1, 0x00 },
+    { SYSTEM__THRESH_RATE_LOW, 0x00 },
+    { SYSTEM__THRESH_RATE_LOW + 1, 0x00 },
+    { DSS_CONFIG__APERTURE_ATTENUATION, 0x38 },
+    // timing config
+    // most of these settings will be determined later by distance and timing
+    // budget configuration
+    { RANGE_CONFIG__SIGMA_THRESH, 360 >> 8 }, // tuning parm default
+    { RANGE_CONFIG__SIGMA_THRESH + 1, 360 & 0xFF },
+    { RANGE_CONFIG__MIN_COUNT_RATE_RTN_LIMIT_MCPS, 192 >> 8 }, // tuning parm default
+    { RANGE_CONFIG__MIN_COUNT_RATE_RTN_LIMIT_MCPS + 1, 192 & 0xFF },
+    // dynamic config
+    { SYSTEM__GROUPED_PARAMETER_HOLD_0, 0x01 },
+    { SYSTEM__GROUPED_PARAMETER_HOLD_1, 0x01 },
+    { SD_CONFIG__QUANTIFIER, 2 }, // tuning parm default
+    // from VL53L1_preset_mode_timed_ranging_*
+    // GPH is 0 after reset, but writing GPH0 and GPH1 above seem to set GPH to 1,
+    // and things don't seem to work if we don't set GPH back to 0 (which the API
+    // does here).
+    { SYSTEM__GROUPED_PARAMETER_HOLD, 0x00 },
+    { SYSTEM__SEED_CONFIG, 1 }, // tuning parm default
+    // from VL53L1_config_low_power_auto_mode
+    { SYSTEM__SEQUENCE_CONFIG, 0x8B }, // VHV, PHASECAL, DSS1, RANGE
+    { DSS_CONFIG__MANUAL_EFFECTIVE_SPADS_SELECT, 200 },
+    { DSS_CONFIG__MANUAL_EFFECTIVE_SPADS_SELECT + 1, 0 },
+    { DSS_CONFIG__ROI_MODE_CONTROL, 2 } // REQUESTED_EFFFECTIVE_SPADS
+};
+
+const uint8_t STATIC_CONFIG_COUNT = sizeof(STATIC_CONFIG) / sizeof(I2CRegisterValue);
+
+#define DISTANCE_MODE_CONFIG_COUNT 7
+
+/*
+ * timing and dynamic configuration for the short, medium and long distance
+ * modes from VL53L1_preset_mode_standard_ranging_short_range(),
+ * VL53L1_preset_mode_standard_ranging() and
+ * VL53L1_preset_mode_standard_ranging_long_range()
+ */
+const I2CRegisterValue DISTANCE_MODE_CONFIG[3][DISTANCE_MODE_CONFIG_COUNT] = {
+    {
+        { RANGE_CONFIG__VCSEL_PERIOD_A, 0x07 },
+        { RANGE_CONFIG__VCSEL_PERIOD_B, 0x05 },
+        { RANGE_CONFIG__VALID_PHASE_HIGH, 0x38 },
+        { SD_CONFIG__WOI_SD0, 0x07 },
+        { SD_CONFIG__WOI_SD1, 0x05 },
+        { SD_CONFIG__INITIAL_PHASE_SD0, 6 }, // tuning parm default
+        { SD_CONFIG__INITIAL_PHASE_SD1, 6 } // tuning parm default
+    },
+    {
+        { RANGE_CONFIG__VCSEL_PERIOD_A, 0x0B },
+        { RANGE_CONFIG__VCSEL_PERIOD_B, 0x09 },
+        { RANGE_CONFIG__VALID_PHASE_HIGH, 0x78 },
+        { SD_CONFIG__WOI_SD0, 0x0B },
+        { SD_CONFIG__WOI_SD1, 0x09 },
+        { SD_CONFIG__INITIAL_PHASE_SD0, 10 }, // tuning parm default
+        { SD_CONFIG__INITIAL_PHASE_SD1, 10 } // tuning parm default
+    },
+    {
+        { RANGE_CONFIG__VCSEL_PERIOD_A, 0x0F },
+        { RANGE_CONFIG__VCSEL_PERIOD_B, 0x0D },
+        { RANGE_CONFIG__VALID_PHASE_HIGH, 0xB8 },
+        { SD_CONFIG__WOI_SD0, 0x0F },
+        { SD_CONFIG__WOI_SD1, 0x0D },
+        { SD_CONFIG__INITIAL_PHASE_SD0, 14 }, // tuning parm default
+        { SD_CONFIG__INITIAL_PHASE_SD1, 14 } // tuning parm default
+    }
+};
+
 /*
  * Decode sequence step timeout in MCLKs from register value
  * based on VL53L1_decode_timeout()
@@ -120,6 +229,14 @@ uint16_t encodeTimeout(uint32_t timeout_mclks)
     return (ms_byte << 8) | (ls_byte & 0xFF);
 }
 
+/*
+ * Store an encoded 16 bit timeout big endian in a register buffer
+ */
+void setTimeout(uint8_t* data, uint8_t pos, uint16_t value) {
+    data[pos] = value >> 8;
+    data[pos + 1] = value & 0xFF;
+}
+
 /* 
  * Convert sequence step timeout from macro periods to microseconds with given
  * macro period in microseconds (12.12 format)
@@ -138,26 +255,60 @@ uint32_t timeoutMicrosecondsToMclks(uint32_t timeout_us, uint32_t macro_period_u
     return ((timeout_us << 12) + (macro_period_us >> 1)) / macro_period_us;
 }
 
+/*
+ * Number of the SPAD in column x and row y, counted from the corner at pin 1.
+ * The upper half is numbered 128 to 255 column by column from pin 1, the
+ * lower half 127 to 0 from the opposite side.
+ */
+uint8_t spadNumber(uint8_t x, uint8_t y) {
+    return y < 8 ? 128 + 8 * x + y : 127 - 8 * x - (y - 8);
+}
+
+uint8_t roiSize(uint8_t size) {
+    if (size < MIN_ROI_SIZE) {
+        return MIN_ROI_SIZE;
+    }
+
+    return size > MAX_ROI_SIZE ? MAX_ROI_SIZE : size;
+}
+
 /******************************************************************************
  * class VL53L1X
  *****************************************************************************/
 
+// the sensor raising the interrupt, there is only one on the bus
+static VL53L1X* interruptSensor = NULL;
+
 VL53L1X::VL53L1X(uint8_t address)
   : I2CDevice(address)
+  , _calibrated(false)
+  , _calibrationValid(false)
+  , _clearInterrupt(0x01)
   , _distanceMode(Unknown)
-  , calibrated(false)
-  , saved_vhv_init(0)
-  , saved_vhv_timeout(0)
+  , _interruptPending(false)
+  , _interruptMs(0)
+  , _interruptPin(VL53L1X_NO_PIN)
+  , _periodMs(0)
+  , _readZone(0)
+  , _readyMs(0)
+  , _sampleMs(0)
+  , _sampleReady(false)
+  , _sampleZone(0)
+  , _status(0)
+  , _zone(0)
+  , _zoneCount(0)
 {
+    memset(&_calibration, 0, sizeof(_calibration));
 }
 
-bool VL53L1X::init(bool io_2v8) {
+bool VL53L1X::init(DistanceMode distanceMode, uint32_t budget_us, uint32_t period_ms, bool io_2v8) {
     // check model ID and module type registers (values specified in datasheet)
     if (readReg16Bit(IDENTIFICATION__MODEL_ID) != 0xEACC) {
         return false;
     }
 
     // VL53L1_software_reset() begin
+    _calibrated = false;
     writeReg(SOFT_RESET, 0x00);
     delayMicroseconds(100);
     writeReg(SOFT_RESET, 0x01);
@@ -176,9 +327,16 @@ bool VL53L1X::init(bool io_2v8) {
         readReg(PAD_I2C_HV__EXTSUP_CONFIG) | 0x01);
     }
 
-    // store oscillator info for later use
+    // store oscillator info for later use, the fast oscillator frequency
+    // tells whether a calibration of an earlier start belongs to this sensor
     _oscFastFrequency = readReg16Bit(OSC_MEASURED__FAST_OSC__FREQUENCY);
-    _oscCalibrateVal = readReg16Bit(RESULT__OSC_CALIBRATE_VAL);
+    if (_calibrationValid && _calibration.fastOscFrequency == _oscFastFrequency) {
+        _oscCalibrateVal = _calibration.oscCalibrateVal;
+    }
+    else {
+        _calibrationValid = false;
+        _oscCalibrateVal = readReg16Bit(RESULT__OSC_CALIBRATE_VAL);
+    }
 
     // VL53L1_DataInit() end
 
@@ -193,59 +351,13 @@ bool VL53L1X::init(bool io_2v8) {
     // the API sets the preset mode to LOWPOWER_AUTONOMOUS here:
     // VL53L1_set_preset_mode() begin
 
-    // VL53L1_preset_mode_standard_ranging() begin
-
-    // values labeled "tuning parm default" are from vl53l1_tuning_parm_defaults.h
-    // (API uses these in VL53L1_init_tuning_parm_storage_struct())
-
-    // static config
-    // API resets PAD_I2C_HV__EXTSUP_CONFIG here, but maybe we don't want to do
-    // that? (seems like it would disable 2V8 mode)
-    writeReg16Bit(DSS_CONFIG__TARGET_TOTAL_RATE_MCPS, TARGET_RATE); // should already be this value after reset
-    writeReg(GPIO__TIO_HV_STATUS, 0x02);
-    writeReg(SIGMA_ESTIMATOR__EFFECTIVE_PULSE_WIDTH_NS, 8); // tuning parm default
-    writeReg(SIGMA_ESTIMATOR__EFFECTIVE_AMBIENT_WIDTH_NS, 16); // tuning parm default
-    writeReg(ALGO__CROSSTALK_COMPENSATION_VALID_HEIGHT_MM, 0x01);
-    writeReg(ALGO__RANGE_IGNORE_VALID_HEIGHT_MM, 0xFF);
-    writeReg(ALGO__RANGE_MIN_CLIP, 0); // tuning parm default
-    writeReg(ALGO__CONSISTENCY_CHECK__TOLERANCE, 2); // tuning parm default
-
-    // general config
-    writeReg16Bit(SYSTEM__THRESH_RATE_HIGH, 0x0000);
-    writeReg16Bit(SYSTEM__THRESH_RATE_LOW, 0x0000);
-    writeReg(DSS_CONFIG__APERTURE_ATTENUATION, 0x38);
-
-    // timing config
-    // most of these settings will be determined later by distance and timing
-    // budget configuration
-    writeReg16Bit(RANGE_CONFIG__SIGMA_THRESH, 360); // tuning parm default
-    writeReg16Bit(RANGE_CONFIG__MIN_COUNT_RATE_RTN_LIMIT_MCPS, 192); // tuning parm default
-
-    // dynamic config
-    writeReg(SYSTEM__GROUPED_PARAMETER_HOLD_0, 0x01);
-    writeReg(SYSTEM__GROUPED_PARAMETER_HOLD_1, 0x01);
-    writeReg(SD_CONFIG__QUANTIFIER, 2); // tuning parm default
+    writeRegisterList16(STATIC_CONFIG, STATIC_CONFIG_COUNT);
 
-    // VL53L1_preset_mode_standard_ranging() end
-  
-    // from VL53L1_preset_mode_timed_ranging_*
-    // GPH is 0 after reset, but writing GPH0 and GPH1 above seem to set GPH to 1,
-    // and things don't seem to work if we don't set GPH back to 0 (which the API
-    // does here).
-    writeReg(SYSTEM__GROUPED_PARAMETER_HOLD, 0x00);
-    writeReg(SYSTEM__SEED_CONFIG, 1); // tuning parm default
-
-    // from VL53L1_config_low_power_auto_mode
-    writeReg(SYSTEM__SEQUENCE_CONFIG, 0x8B); // VHV, PHASECAL, DSS1, RANGE
-    writeReg16Bit(DSS_CONFIG__MANUAL_EFFECTIVE_SPADS_SELECT, 200 << 8);
-    writeReg(DSS_CONFIG__ROI_MODE_CONTROL, 2); // REQUESTED_EFFFECTIVE_SPADS
-  
     // VL53L1_set_preset_mode() end
   
-    // default to long range, 50 ms timing budget
-    // note that this is different than what the API defaults to
-    setDistanceMode(Long);
-    writeMeasurementTimingBudget(50000);
+    // note that the API defaults to a 33 ms timing budget
+    setDistanceMode(distanceMode);
+    writeMeasurementTimingBudget(budget_us);
 
     // VL53L1_StaticInit() end
 
@@ -253,58 +365,36 @@ bool VL53L1X::init(bool io_2v8) {
     // measurement is started; assumes MM1 and MM2 are disabled
     writeReg16Bit(ALGO__PART_TO_PART_RANGE_OFFSET_MM,
     readReg16Bit(MM_CONFIG__OUTER_OFFSET_MM) * 4);
-    startContinuous(50);
+    restoreCalibration();
+    startContinuous(period_ms);
     return true;
 }
 
 
+void VL53L1X::setCalibration(const VL53L1XCalibration& calibration) {
+    _calibration = calibration;
+    _calibrationValid = calibration.fastOscFrequency != 0;
+}
+
+
+bool VL53L1X::setRanging(DistanceMode distanceMode, uint32_t budget_us, uint32_t period_ms) {
+    stopContinuous();
+    bool result = setDistanceMode(distanceMode) && writeMeasurementTimingBudget(budget_us);
+    restoreCalibration();
+    startContinuous(period_ms);
+    return result;
+}
+
+
 bool VL53L1X::setDistanceMode(DistanceMode distanceMode) {
-    // save existing timing budget
-    uint32_t budget_us = readMeasurementTimingBudget();
-    switch (distanceMode) {
-    case Short:
-        // from VL53L1_preset_mode_standard_ranging_short_range()
-        // timing config
-        writeReg(RANGE_CONFIG__VCSEL_PERIOD_A, 0x07);
-        writeReg(RANGE_CONFIG__VCSEL_PERIOD_B, 0x05);
-        writeReg(RANGE_CONFIG__VALID_PHASE_HIGH, 0x38);
-        // dynamic config
-        writeReg(SD_CONFIG__WOI_SD0, 0x07);
-        writeReg(SD_CONFIG__WOI_SD1, 0x05);
-        writeReg(SD_CONFIG__INITIAL_PHASE_SD0, 6); // tuning parm default
-        writeReg(SD_CONFIG__INITIAL_PHASE_SD1, 6); // tuning parm default
-        break;
-
-    case Medium:
-        // from VL53L1_preset_mode_standard_ranging()
-         // timing config
-        writeReg(RANGE_CONFIG__VCSEL_PERIOD_A, 0x0B);
-        writeReg(RANGE_CONFIG__VCSEL_PERIOD_B, 0x09);
-        writeReg(RANGE_CONFIG__VALID_PHASE_HIGH, 0x78);
-         // dynamic config
-        writeReg(SD_CONFIG__WOI_SD0, 0x0B);
-        writeReg(SD_CONFIG__WOI_SD1, 0x09);
-        writeReg(SD_CONFIG__INITIAL_PHASE_SD0, 10); // tuning parm default
-        writeReg(SD_CONFIG__INITIAL_PHASE_SD1, 10); // tuning parm default
-        break;
-
-    case Long: // long
-        // from VL53L1_preset_mode_standard_ranging_long_range()
-        // timing config
-        writeReg(RANGE_CONFIG__VCSEL_PERIOD_A, 0x0F);
-        writeReg(RANGE_CONFIG__VCSEL_PERIOD_B, 0x0D);
-        writeReg(RANGE_CONFIG__VALID_PHASE_HIGH, 0xB8);
-        // dynamic config
-        writeReg(SD_CONFIG__WOI_SD0, 0x0F);
-        writeReg(SD_CONFIG__WOI_SD1, 0x0D);
-        writeReg(SD_CONFIG__INITIAL_PHASE_SD0, 14); // tuning parm default
-        writeReg(SD_CONFIG__INITIAL_PHASE_SD1, 14); // tuning parm default
-        break;
-
-    default:
+    if (distanceMode == Unknown) {
         return false;
     }
 
+    // save existing timing budget
+    uint32_t budget_us = readMeasurementTimingBudget();
+    writeRegisterList16(DISTANCE_MODE_CONFIG[distanceMode], DISTANCE_MODE_CONFIG_COUNT);
+
     // reapply timing budget
     writeMeasurementTimingBudget(budget_us);
     _distanceMode = distanceMode;
@@ -327,10 +417,15 @@ bool VL53L1X::writeMeasurementTimingBudget(uint32_t budget_us) {
 
     // VL53L1_calc_timeout_register_values() begin
 
+    // RANGE_CONFIG__VCSEL_PERIOD_A up to RANGE_CONFIG__VCSEL_PERIOD_B
+    uint8_t vcselPeriods[4];
+    readRegisters16(RANGE_CONFIG__VCSEL_PERIOD_A, vcselPeriods, 4);
+    // MM_CONFIG__TIMEOUT_MACROP_A up to RANGE_CONFIG__TIMEOUT_MACROP_B
+    uint8_t timeouts[9];
     uint32_t macro_period_us;
 
     // "Update Macro Period for Range A VCSEL Period"
-    macro_period_us = calcMacroPeriod(readReg(RANGE_CONFIG__VCSEL_PERIOD_A));
+    macro_period_us = calcMacroPeriod(vcselPeriods[0]);
 
     // "Update Phase timeout - uses Timing A"
     // Timeout of 1000 is tuning parm default (TIMED_PHASECAL_CONFIG_TIMEOUT_US_DEFAULT)
@@ -349,21 +444,24 @@ bool VL53L1X::writeMeasurementTimingBudget(uint32_t budget_us) {
     // retrieved, recalculated with a different macro period, and reassigned,
     // but it probably doesn't matter because it seems like the MM ("mode
     // mitigation"?) sequence steps are disabled in low power auto mode anyway.
-    writeReg16Bit(MM_CONFIG__TIMEOUT_MACROP_A, encodeTimeout(timeoutMicrosecondsToMclks(1, macro_period_us)));
+    setTimeout(timeouts, 0, encodeTimeout(timeoutMicrosecondsToMclks(1, macro_period_us)));
 
     // "Update Range Timing A timeout"
-    writeReg16Bit(RANGE_CONFIG__TIMEOUT_MACROP_A, encodeTimeout(timeoutMicrosecondsToMclks(range_config_timeout_us, macro_period_us)));
+    setTimeout(timeouts, 4, encodeTimeout(timeoutMicrosecondsToMclks(range_config_timeout_us, macro_period_us)));
+    // RANGE_CONFIG__VCSEL_PERIOD_A lies in between and is written unchanged
+    timeouts[6] = vcselPeriods[0];
 
     // "Update Macro Period for Range B VCSEL Period"
-    macro_period_us = calcMacroPeriod(readReg(RANGE_CONFIG__VCSEL_PERIOD_B));
+    macro_period_us = calcMacroPeriod(vcselPeriods[3]);
 
     // "Update MM Timing B timeout"
     // (See earlier comment about MM Timing A timeout.)
-    writeReg16Bit(MM_CONFIG__TIMEOUT_MACROP_B, encodeTimeout(timeoutMicrosecondsToMclks(1, macro_period_us)));
+    setTimeout(timeouts, 2, encodeTimeout(timeoutMicrosecondsToMclks(1, macro_period_us)));
 
     // "Update Range Timing B timeout"
-    writeReg16Bit(RANGE_CONFIG__TIMEOUT_MACROP_B, encodeTimeout(timeoutMicrosecondsToMclks(range_config_timeout_us, macro_period_us)));
+    setTimeout(timeouts, 7, encodeTimeout(timeoutMicrosecondsToMclks(range_config_timeout_us, macro_period_us)));
 
+    writeRegisters16(MM_CONFIG__TIMEOUT_MACROP_A, timeouts, 9);
     // VL53L1_calc_timeout_register_values() end
     return true;
 }
@@ -373,38 +471,43 @@ uint32_t VL53L1X::readMeasurementTimingBudget() {
     // assumes PresetMode is LOWPOWER_AUTONOMOUS and these sequence steps are
     // enabled: VHV, PHASECAL, DSS1, RANGE
     // VL53L1_get_timeouts_us() begin
+    // RANGE_CONFIG__TIMEOUT_MACROP_A and RANGE_CONFIG__VCSEL_PERIOD_A
+    uint8_t data[3];
+    readRegisters16(RANGE_CONFIG__TIMEOUT_MACROP_A, data, 3);
     // "Update Macro Period for Range A VCSEL Period"
-    uint32_t macro_period_us = calcMacroPeriod(readReg(RANGE_CONFIG__VCSEL_PERIOD_A));
+    uint32_t macro_period_us = calcMacroPeriod(data[2]);
     // "Get Range Timing A timeout"
-    uint32_t range_config_timeout_us = timeoutMclksToMicroseconds(decodeTimeout(readReg16Bit(RANGE_CONFIG__TIMEOUT_MACROP_A)), macro_period_us);
+    uint32_t range_config_timeout_us = timeoutMclksToMicroseconds(decodeTimeout((static_cast<uint16_t>(data[0]) << 8) | data[1]), macro_period_us);
     // VL53L1_get_timeouts_us() end
     return  2 * range_config_timeout_us + TIMING_GUARD;
 }
 
 
 void VL53L1X::startContinuous(uint32_t period_ms) {
+    _periodMs = period_ms;
     // from VL53L1_set_inter_measurement_period_ms()
     writeReg32Bit(SYSTEM__INTERMEASUREMENT_PERIOD, period_ms * _oscCalibrateVal);
-    writeReg(SYSTEM__INTERRUPT_CLEAR, 0x01); // sys_interrupt_clear_range
-    writeReg(SYSTEM__MODE_START, 0x40); // mode_range__timed
+    // SYSTEM__INTERRUPT_CLEAR and SYSTEM__MODE_START
+    const uint8_t start[2] = {
+        0x01, // sys_interrupt_clear_range
+        0x40 // mode_range__timed
+    };
+    writeRegisters16(SYSTEM__INTERRUPT_CLEAR, start, 2);
 }
 
 
 void VL53L1X::stopContinuous() {
     writeReg(SYSTEM__MODE_START, 0x80);
     // VL53L1_low_power_auto_data_stop_range() begin
-    calibrated = false;
-    // "restore vhv configs"
-    if (saved_vhv_init != 0) {
-        writeReg(VHV_CONFIG__INIT, saved_vhv_init);
-    }
-    
-    if (saved_vhv_timeout != 0) {
-        writeReg(VHV_CONFIG__TIMEOUT_MACROP_LOOP_BOUND, saved_vhv_timeout);
+    if (_calibrated) {
+        _calibrated = false;
+        // "restore vhv configs"
+        writeReg(VHV_CONFIG__INIT, _calibration.vhvInit);
+        writeReg(VHV_CONFIG__TIMEOUT_MACROP_LOOP_BOUND, _calibration.vhvTimeout);
+        // "remove phasecal override"
+        writeReg(PHASECAL_CONFIG__OVERRIDE, 0x00);
     }
 
-    // "remove phasecal override"
-    writeReg(PHASECAL_CONFIG__OVERRIDE, 0x00);
     // VL53L1_low_power_auto_data_stop_range() end
 }
 
@@ -414,6 +517,79 @@ bool VL53L1X::dataReady() {
 }
 
 
+void VL53L1X::setInterruptPin(uint8_t pin) {
+    pinMode(pin, INPUT_PULLUP);
+    interruptSensor = this;
+    _interruptPin = pin;
+    _readyMs = millis();
+    attachInterrupt(digitalPinToInterrupt(pin), interruptHandler, FALLING);
+    // the first measurement may already be waiting, its edge is lost
+    if (digitalRead(pin) == LOW) {
+        _interruptMs = _readyMs;
+        _interruptPending = true;
+    }
+}
+
+
+void VL53L1X::setZones(const VL53L1XZone* zones, uint8_t count) {
+    if (count > VL53L1X_MAX_ZONES) {
+        count = VL53L1X_MAX_ZONES;
+    }
+
+    for (uint8_t i = 0; i < count; ++i) {
+        const VL53L1XZone& zone = zones[i];
+        _roi[i][0] = spadNumber(zone.x & 0x0F, zone.y & 0x0F);
+        _roi[i][1] = (roiSize(zone.height) - 1) << 4 | (roiSize(zone.width) - 1);
+    }
+
+    stopContinuous();
+    _zone = 0;
+    _zoneCount = count;
+    if (count > 0) {
+        writeRegisters16(ROI_CONFIG__USER_ROI_CENTRE_SPAD, _roi[0], 2);
+    }
+    else {
+        const uint8_t full[2] = { FULL_ROI_CENTRE_SPAD, FULL_ROI_SIZE };
+        writeRegisters16(ROI_CONFIG__USER_ROI_CENTRE_SPAD, full, 2);
+    }
+
+    restoreCalibration();
+    startContinuous(_periodMs);
+}
+
+
+bool VL53L1X::requestSample() {
+    unsigned long now = millis();
+    if (interruptDriven()) {
+        noInterrupts();
+        bool pending = _interruptPending;
+        unsigned long readyMs = _interruptMs;
+        _interruptPending = false;
+        interrupts();
+        if (pending) {
+            _readyMs = readyMs;
+            return queueResults();
+        }
+
+        // check the flag if the interrupt is overdue, see statusRead()
+        if (now - _readyMs < 2 * _periodMs) {
+            return true;
+        }
+    }
+    else if (now - _readyMs + POLL_MARGIN_MS < _periodMs) {
+        return true;
+    }
+
+    return queueRead(GPIO__TIO_HV_STATUS, 2, &_status, 1, statusRead, this);
+}
+
+
+uint16_t VL53L1X::takeSample() {
+    _sampleReady = false;
+    return _rangeMM;
+}
+
+
 void VL53L1X::writeReg(uint16_t reg, uint8_t value) {
     beginTransmission();
     write16(reg);
@@ -466,20 +642,46 @@ void VL53L1X::changeAddress(uint8_t address) {
 // based on VL53L1_low_power_auto_setup_manual_calibration()
 void VL53L1X::setupManualCalibration()
 {
-  // "save original vhv configs"
-  saved_vhv_init = readReg(VHV_CONFIG__INIT);
-  saved_vhv_timeout = readReg(VHV_CONFIG__TIMEOUT_MACROP_LOOP_BOUND);
+  // "save original vhv configs", a failed read is retried after the next
+  // measurement instead of storing garbage
+  uint8_t vhv[4];
+  uint8_t phasecal;
+  if (!readRegisters16(VHV_CONFIG__TIMEOUT_MACROP_LOOP_BOUND, vhv, 4) ||
+      !readRegisters16(PHASECAL_RESULT__VCSEL_START, &phasecal, 1)) {
+    return;
+  }
+
+  _calibration.vhvTimeout = vhv[0];
+  _calibration.vhvInit = vhv[VHV_CONFIG__INIT - VHV_CONFIG__TIMEOUT_MACROP_LOOP_BOUND];
+  _calibration.phasecalVcselStart = phasecal;
+  _calibration.distanceMode = _distanceMode;
+  _calibration.fastOscFrequency = _oscFastFrequency;
+  _calibration.oscCalibrateVal = _oscCalibrateVal;
+  _calibrationValid = true;
+  applyManualCalibration();
+}
 
+void VL53L1X::applyManualCalibration()
+{
   // "disable VHV init"
-  writeReg(VHV_CONFIG__INIT, saved_vhv_init & 0x7F);
+  writeReg(VHV_CONFIG__INIT, _calibration.vhvInit & 0x7F);
 
   // "set loop bound to tuning param"
   writeReg(VHV_CONFIG__TIMEOUT_MACROP_LOOP_BOUND,
-    (saved_vhv_timeout & 0x03) + (3 << 2)); // tuning parm default (LOWPOWERAUTO_VHV_LOOP_BOUND_DEFAULT)
+    (_calibration.vhvTimeout & 0x03) + (3 << 2)); // tuning parm default (LOWPOWERAUTO_VHV_LOOP_BOUND_DEFAULT)
 
   // "override phasecal"
   writeReg(PHASECAL_CONFIG__OVERRIDE, 0x01);
-  writeReg(CAL_CONFIG__VCSEL_START, readReg(PHASECAL_RESULT__VCSEL_START));
+  writeReg(CAL_CONFIG__VCSEL_START, _calibration.phasecalVcselStart);
+  _calibrated = true;
+}
+
+// skips the calibration in the first measurement if the sensor has already
+// been calibrated in the current distance mode, also in an earlier start
+void VL53L1X::restoreCalibration() {
+    if (_calibrationValid && _calibration.distanceMode == _distanceMode) {
+        applyManualCalibration();
+    }
 }
 
 uint16_t VL53L1X::readInput() {
@@ -489,33 +691,90 @@ uint16_t VL53L1X::readInput() {
 }
 
 void VL53L1X::readResults() {
-    beginTransmission();
-    write16(RESULT__RANGE_STATUS);
-    endTransmission();
-    requestData(17);
-    _rangeStatus = read();
-    read(); // report_status: not used
-    _streamCount = read();
-    _spadCount  = read16();
-    read16(); // peak_signal_count_rate_mcps_sd0: not used
-    _ambientCountRateMCPS  = read16();
-    read16(); // sigma_sd0: not used
-    read16(); // phase_sd0: not used
-    uint16_t rangeMM  = read16();
-    _peakSignalCountRateMCPS = read16();
+    if (readRegisters16(RESULT__RANGE_STATUS, _results, VL53L1X_RESULTS_SIZE)) {
+        parseResults();
+    }
+}
+
+void VL53L1X::parseResults() {
+    const uint8_t* data = _results;
+    _rangeStatus = data[0] & RANGE_STATUS_MASK;
+    // data[1] report_status: not used
+    _streamCount = data[2];
+    _spadCount = (static_cast<uint16_t>(data[3]) << 8) | data[4];
+    // data[5..6] peak_signal_count_rate_mcps_sd0: not used
+    _ambientCountRateMCPS = (static_cast<uint16_t>(data[7]) << 8) | data[8];
+    // data[9..10] sigma_sd0: not used
+    // data[11..12] phase_sd0: not used
+    uint16_t rangeMM = (static_cast<uint16_t>(data[13]) << 8) | data[14];
+    _peakSignalCountRateMCPS = (static_cast<uint16_t>(data[15]) << 8) | data[16];
 
     // "apply correction gain"
     // gain factor of 2011 is tuning parm default (VL53L1_TUNINGPARM_LITE_RANGING_GAIN_FACTOR_DEFAULT)
     // Basically, this appears to scale the result by 2011/2048, or about 98%
     // (with the 1024 added for proper rounding).
     _rangeMM = (static_cast<uint32_t>(rangeMM) * 2011 + 0x0400) / 0x0800;
-    _measurementValid = _rangeStatus == 9;
+    _measurementValid = _rangeStatus == RANGE_STATUS_VALID || _rangeStatus == RANGE_STATUS_MIN_RANGE_CLIPPED;
+}
+
+bool VL53L1X::queueResults() {
+    if (!queueRead(RESULT__RANGE_STATUS, 2, _results, VL53L1X_RESULTS_SIZE, resultsRead, this)) {
+        return false;
+    }
+
+    _readZone = _zone;
+    if (_zoneCount > 1) {
+        // the next measurement starts after the interrupt has been cleared
+        _zone = (_zone + 1) % _zoneCount;
+        queueWrite(ROI_CONFIG__USER_ROI_CENTRE_SPAD, 2, _roi[_zone], 2);
+    }
+
+    // releases GPIO1 and the data ready flag until the next measurement
+    return queueWrite(SYSTEM__INTERRUPT_CLEAR, 2, &_clearInterrupt, 1);
+}
+
+void VL53L1X::interruptHandler() {
+    if (interruptSensor != NULL) {
+        interruptSensor->_interruptMs = millis();
+        interruptSensor->_interruptPending = true;
+    }
+}
+
+void VL53L1X::resultsRead(void* context, bool success) {
+    VL53L1X* self = static_cast<VL53L1X*>(context);
+    if (success) {
+        self->parseResults();
+        if (!self->_calibrated) {
+            // blocking, but only once after ranging has started
+            self->setupManualCalibration();
+        }
+
+        self->updateDSS();
+        self->_sampleMs = self->_readyMs;
+        self->_sampleReady = true;
+        self->_sampleZone = self->_readZone;
+    }
+}
+
+void VL53L1X::statusRead(void* context, bool success) {
+    VL53L1X* self = static_cast<VL53L1X*>(context);
+    if (success && (self->_status & 0x01) == 0) {
+        self->_readyMs = millis();
+        if (self->interruptDriven()) {
+            // a measurement is ready but the interrupt did not arrive
+            detachInterrupt(digitalPinToInterrupt(self->_interruptPin));
+            self->_interruptPin = VL53L1X_NO_PIN;
+        }
+
+        self->queueResults();
+    }
 }
 
 
 /*
  * perform Dynamic SPAD Selection calculation/update
  * based on VL53L1_low_power_auto_update_DSS()
+ * the new setting is queued, see I2CQueue
  */
 void VL53L1X::updateDSS() {
     if (_spadCount != 0) {
@@ -540,7 +799,7 @@ void VL53L1X::updateDSS() {
             }
 
             // "override DSS config"
-            writeReg16Bit(DSS_CONFIG__MANUAL_EFFECTIVE_SPADS_SELECT, requiredSpads);
+            queueSpadsSelect(requiredSpads);
             // DSS_CONFIG__ROI_MODE_CONTROL should already be set to REQUESTED_EFFFECTIVE_SPADS
             return;
         }
@@ -550,7 +809,14 @@ void VL53L1X::updateDSS() {
     // divide by zero.
     // "We want to gracefully set a spad target, not just exit with an error"
     // "set target to mid point"
-    writeReg16Bit(DSS_CONFIG__MANUAL_EFFECTIVE_SPADS_SELECT, 0x8000);
+    queueSpadsSelect(0x8000);
+}
+
+
+void VL53L1X::queueSpadsSelect(uint16_t spads) {
+    _spadsSelect[0] = spads >> 8;
+    _spadsSelect[1] = spads & 0xFF;
+    queueWrite(DSS_CONFIG__MANUAL_EFFECTIVE_SPADS_SELECT, 2, _spadsSelect, 2);
 }
 
 
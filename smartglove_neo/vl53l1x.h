@@ -15,14 +15,76 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#ifndef VL53L1X_H
+#define VL53L1X_H
+
 #include "i2cdevice.h"
 
+// RESULT__RANGE_STATUS up to the peak signal count rate
+#define VL53L1X_RESULTS_SIZE 17
+#define VL53L1X_NO_PIN 0xFF
+#define VL53L1X_MAX_ZONES 4
+
+/**
+ * Region of interest on the 16x16 SPAD array. x and y are the column and row
+ * of the SPAD at its centre, counted from the corner at pin 1. The size is
+ * between 4 and 16 SPADs in each direction.
+ */
+struct VL53L1XZone {
+    uint8_t x;
+    uint8_t y;
+    uint8_t width;
+    uint8_t height;
+};
+
+/**
+ * Results of the calibration the sensor runs in its first measurement and
+ * its oscillator values. The phase calibration depends on the distance mode
+ * it has been measured in.
+ */
+struct VL53L1XCalibration {
+    uint16_t fastOscFrequency;
+    uint16_t oscCalibrateVal;
+    uint8_t distanceMode;
+    uint8_t phasecalVcselStart;
+    uint8_t vhvInit;
+    uint8_t vhvTimeout;
+};
+
 class VL53L1X : public I2CDevice {
 public:
     enum DistanceMode { Short, Medium, Long, Unknown };
 
     VL53L1X(uint8_t address);
-    bool init(bool io_2v8 = true);
+
+    /**
+     * Initializes the sensor and starts continuous ranging with the given
+     * distance mode, timing budget and inter-measurement period.
+     */
+    bool init(DistanceMode distanceMode, uint32_t budget_us, uint32_t period_ms, bool io_2v8 = true);
+
+    /**
+     * Uses the calibration of an earlier start instead of calibrating after
+     * the first measurement. It is ignored if the sensor's oscillator
+     * frequency differs, and the phase calibration only applies in the
+     * same distance mode. Must be called before init().
+     */
+    void setCalibration(const VL53L1XCalibration& calibration);
+
+    /**
+     * Returns true while ranging with a known calibration, either the one
+     * set by setCalibration() or the one measured after the first
+     * measurement. calibration() can then be stored for the next start.
+     */
+    inline bool calibrated() const { return _calibrated; }
+    inline const VL53L1XCalibration& calibration() const { return _calibration; }
+
+    /**
+     * Stops ranging, changes distance mode and timing budget and restarts
+     * continuous ranging with the given inter-measurement period. The
+     * timing budget must not exceed the period.
+     */
+    bool setRanging(DistanceMode distanceMode, uint32_t budget_us, uint32_t period_ms);
     bool setDistanceMode(DistanceMode distanceMode);
     inline DistanceMode distanceMode() const { return _distanceMode; }
     bool writeMeasurementTimingBudget(uint32_t budget_us);
@@ -47,21 +109,89 @@ public:
 
     uint16_t readInput();
 
+    /**
+     * Uses the GPIO1 output of the sensor, connected to pin, to detect new
+     * measurements instead of polling the data ready flag. Must be called
+     * after init(). Falls back to polling if the sensor has a measurement
+     * ready without having raised the interrupt.
+     */
+    void setInterruptPin(uint8_t pin);
+    inline bool interruptDriven() const { return _interruptPin != VL53L1X_NO_PIN; }
+
+    /**
+     * Queues the read of a new measurement. Without interrupt, the data ready
+     * flag is checked first, but only when the next measurement is due. The
+     * results are read in the background and sampleReady() returns true once
+     * they have arrived. Each measurement is read once.
+     */
+    bool requestSample();
+    inline bool sampleReady() const { return _sampleReady; }
+
+    /**
+     * Returns false if the sensor reported the measurement of the current
+     * sample as failed, its range must not be used.
+     */
+    inline bool sampleValid() const { return _measurementValid; }
+
+    /**
+     * Returns the time in milliseconds at which the measurement of the
+     * current sample became ready.
+     */
+    inline unsigned long sampleMs() const { return _sampleMs; }
+
+    /**
+     * Returns the index of the zone the current sample has been measured in.
+     */
+    inline uint8_t sampleZone() const { return _sampleZone; }
+
+    /**
+     * Measures the zones in turn, one per measurement, so that each zone is
+     * measured at the measurement rate divided by count. With count 0, the
+     * whole SPAD array is used. Restarts continuous ranging.
+     */
+    void setZones(const VL53L1XZone* zones, uint8_t count);
+    inline uint8_t zoneCount() const { return _zoneCount; }
+
+    /**
+     * Returns the range of the sample read by requestSample() in mm and
+     * clears sampleReady().
+     */
+    uint16_t takeSample();
+
     void changeAddress(uint8_t address);
     uint8_t address() { return _address; }
 
 private:
     uint8_t _address;
     uint16_t _ambientCountRateMCPS;
+    bool _calibrated;
+    VL53L1XCalibration _calibration;
+    bool _calibrationValid;
+    uint8_t _clearInterrupt;
     DistanceMode _distanceMode;
+    volatile bool _interruptPending;
+    volatile unsigned long _interruptMs;
+    uint8_t _interruptPin;
     uint16_t _oscFastFrequency;
     uint16_t _oscCalibrateVal;
     uint16_t _peakSignalCountRateMCPS;
+    uint32_t _periodMs;
     uint32_t _rangeMM;
     bool _measurementValid;
     uint8_t _rangeStatus;
+    unsigned long _readyMs;
+    uint8_t _readZone;
+    uint8_t _results[VL53L1X_RESULTS_SIZE];
+    uint8_t _roi[VL53L1X_MAX_ZONES][2];
+    unsigned long _sampleMs;
+    bool _sampleReady;
+    uint8_t _sampleZone;
     uint16_t _spadCount;
+    uint8_t _spadsSelect[2];
+    uint8_t _status;
     uint8_t _streamCount;
+    uint8_t _zone;
+    uint8_t _zoneCount;
     
 
     void writeReg(uint16_t reg, uint8_t value);
@@ -70,14 +200,20 @@ private:
     uint8_t readReg(uint16_t reg);
     uint16_t readReg16Bit(uint16_t reg);
 
-    bool calibrated;
-    uint8_t saved_vhv_init;
-    uint8_t saved_vhv_timeout;
-
     void updateDSS();
+    void queueSpadsSelect(uint16_t spads);
+    void parseResults();
+    bool queueResults();
     void readResults();
+    static void interruptHandler();
+    static void resultsRead(void* context, bool success);
+    static void statusRead(void* context, bool success);
 
+    void applyManualCalibration();
+    void restoreCalibration();
     void setupManualCalibration();
     
     uint32_t calcMacroPeriod(uint8_t vcsel_period);
 };
+
+#endif